@@ -0,0 +1,82 @@
+//
+// File "ApproxConv.cpp"
+// Implementation of class R2ApproxConvex
+//
+#include <math.h>
+#include <float.h>
+#include "ApproxConv.h"
+
+R2ApproxConvex::R2ApproxConvex(int k /* = 64 */):
+    m_NumDirections(k < 4? 2 : (k + 1) / 2),
+    m_NumPoints(0),
+    m_Cos(m_NumDirections),
+    m_Sin(m_NumDirections),
+    m_Max(m_NumDirections),
+    m_MaxX(m_NumDirections),
+    m_MaxY(m_NumDirections),
+    m_Min(m_NumDirections),
+    m_MinX(m_NumDirections),
+    m_MinY(m_NumDirections),
+    m_Proj(m_NumDirections)
+{
+    for (int i = 0; i < m_NumDirections; ++i) {
+        double alpha = M_PI * i / m_NumDirections;
+        m_Cos[i] = cos(alpha);
+        m_Sin[i] = sin(alpha);
+    }
+    initialize();
+}
+
+int R2ApproxConvex::directionsForError(double eps) {
+    if (eps <= 0.)
+        throw R2ConvexException("Nonpositive error");
+    double k = ceil(M_PI / eps);
+    if (k > 1e8)
+        throw R2ConvexException("Too small error");
+    return (k < 4.? 4 : (int) k);
+}
+
+void R2ApproxConvex::initialize() {
+    for (int i = 0; i < m_NumDirections; ++i) {
+        m_Max[i] = (-DBL_MAX);
+        m_Min[i] = DBL_MAX;
+        m_MaxX[i] = 0.; m_MaxY[i] = 0.;
+        m_MinX[i] = 0.; m_MinY[i] = 0.;
+    }
+    m_NumPoints = 0;
+}
+
+void R2ApproxConvex::addPoints(const R2Point* points, int numPoints) {
+    for (int i = 0; i < numPoints; ++i)
+        addPoint(points[i].x, points[i].y);
+}
+
+void R2ApproxConvex::merge(const R2ApproxConvex& a) {
+    if (a.m_NumDirections != m_NumDirections)
+        throw R2ConvexException("Different numbers of directions");
+    for (int i = 0; i < m_NumDirections; ++i) {
+        if (a.m_Max[i] > m_Max[i]) {
+            m_Max[i] = a.m_Max[i];
+            m_MaxX[i] = a.m_MaxX[i]; m_MaxY[i] = a.m_MaxY[i];
+        }
+        if (a.m_Min[i] < m_Min[i]) {
+            m_Min[i] = a.m_Min[i];
+            m_MinX[i] = a.m_MinX[i]; m_MinY[i] = a.m_MinY[i];
+        }
+    }
+    m_NumPoints += a.m_NumPoints;
+}
+
+void R2ApproxConvex::toConvex(R2Convex& convex) const {
+    if (m_NumPoints == 0) {
+        convex.initialize();
+        return;
+    }
+    std::vector<R2Point> points;
+    points.reserve(2*m_NumDirections);
+    for (int i = 0; i < m_NumDirections; ++i) {
+        points.push_back(R2Point(m_MaxX[i], m_MaxY[i]));
+        points.push_back(R2Point(m_MinX[i], m_MinY[i]));
+    }
+    convex.build(&(points[0]), (int) points.size());
+}
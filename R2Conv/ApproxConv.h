@@ -0,0 +1,101 @@
+//
+// File "ApproxConv.h"
+// Interface of class R2ApproxConvex:
+//      approximate convex hull of a large (or streaming) set of
+//      points, kept as the extreme points in k fixed directions.
+// Used classes:
+//      R2Point, R2Convex
+
+#ifndef APPROX_CONV_H
+#   define APPROX_CONV_H
+
+#include <vector>
+#include "R2Graph/R2Graph.h"
+#include "R2Conv.h"
+
+//
+// The directions u[i] = (cos(pi*i/m), sin(pi*i/m)), i = 0..m-1,
+// together with their opposite ones give k = 2*m uniformly spaced
+// directions. For every u[i] we keep the points with maximal and
+// minimal projection to u[i]; their convex hull differs from the
+// exact one by at most pi/k * D (in Hausdorff distance), where D
+// is the diameter of the set. So k = pi/eps directions give the
+// relative error eps, independently of the number of points.
+//
+// The arrays are kept separately (structure of arrays), so that
+// the loop of projections in addPoint can be vectorized.
+//
+// To process the points in several threads, use an object per
+// thread and merge them at the end.
+//
+class R2ApproxConvex {
+    int                 m_NumDirections;    // m = k/2
+    long                m_NumPoints;
+    std::vector<double> m_Cos;
+    std::vector<double> m_Sin;
+    std::vector<double> m_Max;      // Maximal projection to u[i]
+    std::vector<double> m_MaxX;     // The point with maximal projection
+    std::vector<double> m_MaxY;
+    std::vector<double> m_Min;      // Minimal projection to u[i]
+    std::vector<double> m_MinX;
+    std::vector<double> m_MinY;
+    std::vector<double> m_Proj;     // Temporary array of projections
+
+public:
+    // k directions (k is rounded up to an even number, k >= 4)
+    R2ApproxConvex(int k = 64);
+
+    ~R2ApproxConvex() {}
+
+    // Number of directions k sufficient for the relative error eps
+    static int directionsForError(double eps);
+
+    void addPoint(const R2Point& t) {
+        addPoint(t.x, t.y);
+    }
+
+    void addPoint(double x, double y) {
+        int m = m_NumDirections;
+        int i;
+
+        // Projections to all the directions: this loop is vectorized
+        const double* c = &(m_Cos[0]);
+        const double* s = &(m_Sin[0]);
+        double* proj = &(m_Proj[0]);
+        for (i = 0; i < m; ++i)
+            proj[i] = x*c[i] + y*s[i];
+
+        // Update of extreme points (rare for the points inside hull)
+        for (i = 0; i < m; ++i) {
+            if (proj[i] > m_Max[i]) {
+                m_Max[i] = proj[i]; m_MaxX[i] = x; m_MaxY[i] = y;
+            }
+            if (proj[i] < m_Min[i]) {
+                m_Min[i] = proj[i]; m_MinX[i] = x; m_MinY[i] = y;
+            }
+        }
+        ++m_NumPoints;
+    }
+
+    void addPoints(const R2Point* points, int numPoints);
+
+    // Add the points of another approximation with the same
+    // number of directions (e.g. computed in another thread).
+    // Throws R2ConvexException, if the numbers of directions differ.
+    void merge(const R2ApproxConvex& a);
+
+    void initialize();
+
+    // Number of points added
+    long numPoints() const { return m_NumPoints; }
+
+    // Number of directions k
+    int numDirections() const { return 2*m_NumDirections; }
+
+    // Replace the convex by the hull of extreme points, O(k log k)
+    void toConvex(R2Convex& convex) const;
+};
+
+#endif
+//
+// End of file "ApproxConv.h"
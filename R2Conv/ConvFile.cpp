@@ -0,0 +1,232 @@
+//
+// File "ConvFile.cpp"
+// Implementation of classes R2ConvexView, R2ConvexWriter, R2ConvexFile
+//
+#include <assert.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include "ConvFile.h"
+#include "ConvQuery.h"
+
+// Header of record of a hull; the vertices follow it
+struct ConvexRecord {
+    int32_t numVertices;
+    int32_t reserved;
+    double  area;
+    double  perimeter;
+};
+
+// Header of file of hulls
+struct ConvexFileHeader {
+    char        magic[4];
+    int32_t     version;
+    uint64_t    numHulls;
+    uint64_t    tableOffset;
+};
+
+static const char CONVEX_FILE_MAGIC[4] = { 'R', '2', 'C', 'H' };
+static const int CONVEX_FILE_VERSION = 1;
+
+size_t convexRecordSize(const R2Convex& c) {
+    return sizeof(ConvexRecord) + c.size() * sizeof(R2Point);
+}
+
+size_t serializeConvex(const R2Convex& c, void* buffer) {
+    ConvexRecord* r = (ConvexRecord*) buffer;
+    r->numVertices = c.size();
+    r->reserved = 0;
+    r->area = c.area();
+    r->perimeter = c.perimeter();
+    R2Point* v = (R2Point*)(r + 1);
+    R2PointSpan span[2];
+    int n = c.spans(span[0], span[1]);
+    for (int k = 0; k < n; ++k) {
+        v = std::copy(span[k].begin(), span[k].end(), v);
+    }
+    return convexRecordSize(c);
+}
+
+R2ConvexView::R2ConvexView(const void* record) {
+    const ConvexRecord* r = (const ConvexRecord*) record;
+    m_Vertices = (const R2Point*)(r + 1);
+    m_Size = r->numVertices;
+    m_Area = r->area;
+    m_Perimeter = r->perimeter;
+}
+
+bool R2ConvexView::contains(const R2Point& t) const {
+    if (m_Size == 0)
+        return false;
+    else if (m_Size == 1)
+        return (t == m_Vertices[0]);
+    else if (m_Size == 2)
+        return t.between(m_Vertices[0], m_Vertices[1]);
+    else
+        return convexContains(m_Vertices, m_Size, t);
+}
+
+double R2ConvexView::distance(const R2Point& t) const {
+    if (m_Size == 0)
+        throw R2ConvexException("Empty convex");
+    else if (m_Size == 1)
+        return t.distance(m_Vertices[0]);
+    else if (m_Size == 2)
+        return segmentDistance(t, m_Vertices[0], m_Vertices[1]);
+    else
+        return convexDistance(m_Vertices, m_Size, t);
+}
+
+bool R2ConvexView::tangents(
+    const R2Point& t, R2Point& left, R2Point& right
+) const {
+    if (contains(t) || m_Size == 0)
+        return false;
+    int l, r;
+    convexTangents(m_Vertices, m_Size, t, l, r);
+    left = m_Vertices[l]; right = m_Vertices[r];
+    return true;
+}
+
+R2Point R2ConvexView::extremeVertex(const R2Vector& d) const {
+    if (m_Size == 0)
+        throw R2ConvexException("Empty convex");
+    return m_Vertices[convexExtremeVertex(m_Vertices, m_Size, d)];
+}
+
+void R2ConvexView::toConvex(R2Convex& c) const {
+    c.assign(m_Vertices, m_Size, m_Area, m_Perimeter);
+}
+
+// End of implementation of the class R2ConvexView
+//======================================================
+
+bool R2ConvexWriter::open(const char* path) {
+    close();
+    m_File = fopen(path, "wb");
+    if (m_File == 0)
+        return false;
+    m_Offsets.clear();
+    m_Position = 0;
+    m_Error = false;
+
+    // The header is rewritten by close()
+    ConvexFileHeader h;
+    memset(&h, 0, sizeof(h));
+    write(&h, sizeof(h));
+    return true;
+}
+
+void R2ConvexWriter::add(const R2Convex& c) {
+    assert(m_File != 0);
+    size_t len = convexRecordSize(c);
+    m_Buffer.resize(len / sizeof(double));
+    serializeConvex(c, &(m_Buffer[0]));
+    m_Offsets.push_back(m_Position);
+    write(&(m_Buffer[0]), len);
+}
+
+void R2ConvexWriter::write(const void* data, size_t len) {
+    if (fwrite(data, 1, len, m_File) != len)
+        m_Error = true;
+    m_Position += len;
+}
+
+bool R2ConvexWriter::close() {
+    if (m_File == 0)
+        return !m_Error;
+    ConvexFileHeader h;
+    memcpy(h.magic, CONVEX_FILE_MAGIC, sizeof(h.magic));
+    h.version = CONVEX_FILE_VERSION;
+    h.numHulls = m_Offsets.size();
+    h.tableOffset = m_Position;
+    if (!m_Offsets.empty())
+        write(&(m_Offsets[0]), m_Offsets.size() * sizeof(uint64_t));
+    if (
+        fseek(m_File, 0, SEEK_SET) != 0 ||
+        fwrite(&h, sizeof(h), 1, m_File) != 1
+    )
+        m_Error = true;
+    if (fclose(m_File) != 0)
+        m_Error = true;
+    m_File = 0;
+    return !m_Error;
+}
+
+// End of implementation of the class R2ConvexWriter
+//======================================================
+
+bool R2ConvexFile::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(ConvexFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(0, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    m_Data = (const char*) p;
+    m_Length = (size_t) st.st_size;
+
+    const ConvexFileHeader* h = (const ConvexFileHeader*) m_Data;
+    if (
+        memcmp(h->magic, CONVEX_FILE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != CONVEX_FILE_VERSION ||
+        h->tableOffset % sizeof(uint64_t) != 0 ||
+        h->tableOffset > m_Length ||
+        h->numHulls > (m_Length - h->tableOffset) / sizeof(uint64_t)
+    ) {
+        close();
+        return false;
+    }
+    m_Offsets = (const uint64_t*)(m_Data + h->tableOffset);
+    m_Size = (int) h->numHulls;
+    if (!check()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Are all the records inside the file?
+bool R2ConvexFile::check() const {
+    for (int i = 0; i < m_Size; ++i) {
+        uint64_t offset = m_Offsets[i];
+        if (
+            offset % sizeof(double) != 0 ||
+            offset > m_Length ||
+            m_Length - offset < sizeof(ConvexRecord)
+        )
+            return false;
+        const ConvexRecord* r = (const ConvexRecord*)(m_Data + offset);
+        if (
+            r->numVertices < 0 ||
+            (m_Length - offset - sizeof(ConvexRecord)) / sizeof(R2Point) <
+                (uint64_t) r->numVertices
+        )
+            return false;
+    }
+    return true;
+}
+
+void R2ConvexFile::close() {
+    if (m_Data != 0)
+        munmap((void*) m_Data, m_Length);
+    m_Data = 0;
+    m_Length = 0;
+    m_Offsets = 0;
+    m_Size = 0;
+}
+
+R2ConvexView R2ConvexFile::operator[](int i) const {
+    assert(i >= 0 && i < m_Size);
+    return R2ConvexView(m_Data + m_Offsets[i]);
+}
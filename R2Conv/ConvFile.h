@@ -0,0 +1,178 @@
+//
+// File "ConvFile.h"
+// Binary storage of convex hulls:
+//      R2ConvexView   - read-only hull stored in memory (in a buffer
+//                       or in a file mapped to memory), used in place;
+//      R2ConvexWriter - writes a file of many hulls;
+//      R2ConvexFile   - maps such a file to memory and gives the
+//                       views of its hulls.
+// Used classes:
+//      R2Convex, R2Point, R2Vector
+//
+// Record of a hull (all numbers in the native byte order):
+//      int32   number of vertices n
+//      int32   reserved (0)
+//      double  area
+//      double  perimeter
+//      double  x, y of vertices (n pairs), clockwise, as in R2Convex
+// File of hulls:
+//      char    magic "R2CH"
+//      int32   version (1)
+//      int64   number of hulls m
+//      int64   offset of the table of records
+//      ...     records (each one begins at offset multiple of 8)
+//      int64   offsets of records from the beginning of file (m)
+
+#ifndef CONV_FILE_H
+#   define CONV_FILE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "R2Graph/R2Graph.h"
+#include "R2Conv.h"
+
+// Size of record of the convex c in bytes
+size_t convexRecordSize(const R2Convex& c);
+
+// Write the record of the convex c to the buffer, which must have
+// room for convexRecordSize(c) bytes and be aligned to 8 bytes.
+// Return value: the size of record
+size_t serializeConvex(const R2Convex& c, void* buffer);
+
+//
+// Hull stored as a record. The vertices are not copied:
+// the view is valid while the memory of record exists.
+// The queries are the same as of R2Convex, in O(log n).
+//
+class R2ConvexView {
+    const R2Point*  m_Vertices;
+    int             m_Size;
+    double          m_Area;
+    double          m_Perimeter;
+
+public:
+    R2ConvexView():
+        m_Vertices(0),
+        m_Size(0),
+        m_Area(0.),
+        m_Perimeter(0.)
+    {}
+
+    // The record must be aligned to 8 bytes
+    R2ConvexView(const void* record);
+
+    int size() const { return m_Size; }
+    double area() const { return m_Area; }
+    double perimeter() const { return m_Perimeter; }
+
+    // Vertices clockwise, as in R2Convex
+    const R2Point* begin() const { return m_Vertices; }
+    const R2Point* end() const { return m_Vertices + m_Size; }
+    const R2Point& operator[](int i) const { return m_Vertices[i]; }
+
+    // Loop for each vertex (see R2Polygon::forEach)
+    // Return value: true, if loop was broken
+    template <class Action>
+    bool forEach(Action action) const {
+        for (int i = 0; i < m_Size; ++i) {
+            if (action(m_Vertices[i]))
+                return true;
+        }
+        return false;
+    }
+
+    // See R2Convex::contains, distance, tangents, extremeVertex
+    bool contains(const R2Point& t) const;
+    double distance(const R2Point& t) const;
+    bool tangents(const R2Point& t, R2Point& left, R2Point& right) const;
+    R2Point extremeVertex(const R2Vector& d) const;
+
+    // Copy the hull to the convex c (the hull is not recomputed)
+    void toConvex(R2Convex& c) const;
+};
+
+//
+// Writer of a file of hulls. The records are written one
+// after another; the table of offsets is written by close().
+//
+class R2ConvexWriter {
+    FILE*                   m_File;
+    std::vector<uint64_t>   m_Offsets;
+    uint64_t                m_Position;
+    std::vector<double>     m_Buffer;   // Record (aligned to 8 bytes)
+    bool                    m_Error;    // Output error occurred
+
+public:
+    R2ConvexWriter():
+        m_File(0),
+        m_Offsets(),
+        m_Position(0),
+        m_Buffer(),
+        m_Error(false)
+    {}
+
+    ~R2ConvexWriter() { close(); }
+
+    // Return value: false, if the file cannot be created
+    bool open(const char* path);
+
+    void add(const R2Convex& c);
+
+    // Number of hulls written
+    int size() const { return (int) m_Offsets.size(); }
+
+    // Write the table of offsets and close the file
+    // Return value: false, if an output error occurred
+    bool close();
+
+private:
+    R2ConvexWriter(const R2ConvexWriter&);              // Not implemented
+    R2ConvexWriter& operator=(const R2ConvexWriter&);   // Not implemented
+
+    void write(const void* data, size_t len);
+};
+
+//
+// File of hulls mapped to memory. Opening costs O(1) besides
+// the check of table of offsets; the hulls are read in place,
+// when they are accessed.
+//
+class R2ConvexFile {
+    const char*     m_Data;
+    size_t          m_Length;
+    const uint64_t* m_Offsets;
+    int             m_Size;
+
+public:
+    R2ConvexFile():
+        m_Data(0),
+        m_Length(0),
+        m_Offsets(0),
+        m_Size(0)
+    {}
+
+    ~R2ConvexFile() { close(); }
+
+    // Return value: false, if the file cannot be opened
+    // or its format is wrong
+    bool open(const char* path);
+    void close();
+
+    // Number of hulls in the file
+    int size() const { return m_Size; }
+
+    // The hull number i, 0 <= i < size()
+    R2ConvexView operator[](int i) const;
+
+private:
+    R2ConvexFile(const R2ConvexFile&);              // Not implemented
+    R2ConvexFile& operator=(const R2ConvexFile&);   // Not implemented
+
+    bool check() const;
+};
+
+#endif
+//
+// End of file "ConvFile.h"
@@ -0,0 +1,319 @@
+//
+// File "ConvGjk.cpp"
+// Implementation of GJK and EPA algorithms for convexes
+//
+#include <math.h>
+#include <assert.h>
+#include <vector>
+#include "ConvGjk.h"
+
+// Point of the Minkowski difference a - b: w = pa - pb, where pa
+// is the extreme vertex of a in the direction dir, pb is the
+// extreme vertex of b in the opposite direction
+class GjkSupport {
+public:
+    R2Point     pa;
+    R2Point     pb;
+    R2Vector    w;
+    R2Vector    dir;
+
+    GjkSupport() {}
+
+    GjkSupport(const R2Convex& a, const R2Convex& b, const R2Vector& d):
+        pa(a.extremeVertex(d)),
+        pb(b.extremeVertex(d * (-1.))),
+        w(),
+        dir(d)
+    {
+        w = pa - pb;
+    }
+};
+
+// Results of the GJK iterations
+const int GJK_SEPARATED = 0;    // v is the closest point of a - b
+const int GJK_OVERLAP = 1;      // a - b contains the origin
+const int GJK_BEYOND = 2;       // The distance is greater than limit
+
+// Find the point v of the simplex s[0..n-1] closest to the origin
+// and its barycentric coordinates lambda. The simplex is reduced
+// to the smallest face containing v.
+// Return value: true, if the simplex (triangle) contains the origin.
+static bool closestPoint(
+    GjkSupport* s, int& n, R2Vector& v, double* lambda
+) {
+    if (n == 3) {
+        double c0 = R2Vector::signed_area(s[0].w, s[1].w);
+        double c1 = R2Vector::signed_area(s[1].w, s[2].w);
+        double c2 = R2Vector::signed_area(s[2].w, s[0].w);
+        double total = c0 + c1 + c2;
+        if (
+            total != 0. && (
+                (c0 >= 0. && c1 >= 0. && c2 >= 0.) ||
+                (c0 <= 0. && c1 <= 0. && c2 <= 0.)
+            )
+        ) {
+            // Barycentric coordinates of the origin
+            lambda[0] = c1 / total;
+            lambda[1] = c2 / total;
+            lambda[2] = c0 / total;
+            v = R2Vector(0., 0.);
+            return true;
+        }
+
+        // The closest point lies on one of edges
+        GjkSupport best[2];
+        int bestSize = 0;
+        double bestLambda[2];
+        R2Vector bestV;
+        double bestDist = 0.;
+        for (int i = 0; i < 3; ++i) {
+            GjkSupport edge[2];
+            edge[0] = s[i];
+            edge[1] = s[i+1 < 3? i+1 : 0];
+            int m = 2;
+            double l[2];
+            R2Vector u;
+            closestPoint(edge, m, u, l);
+            double dist = u * u;
+            if (bestSize == 0 || dist < bestDist) {
+                bestSize = m;
+                best[0] = edge[0]; best[1] = edge[1];
+                bestLambda[0] = l[0]; bestLambda[1] = l[1];
+                bestV = u;
+                bestDist = dist;
+            }
+        }
+        n = bestSize;
+        for (int i = 0; i < n; ++i) {
+            s[i] = best[i];
+            lambda[i] = bestLambda[i];
+        }
+        v = bestV;
+        return false;
+    }
+
+    if (n == 2) {
+        R2Vector e = s[1].w - s[0].w;
+        double ee = e * e;
+        double t = (ee > 0.? -(s[0].w * e) / ee : 0.);
+        if (t <= 0.) {
+            n = 1;
+        } else if (t >= 1.) {
+            s[0] = s[1];
+            n = 1;
+        } else {
+            v = s[0].w + e * t;
+            lambda[0] = 1. - t;
+            lambda[1] = t;
+            return false;
+        }
+    }
+
+    assert(n == 1);
+    v = s[0].w;
+    lambda[0] = 1.;
+    return false;
+}
+
+// The GJK iterations. If limit >= 0, then stop as soon as the
+// distance is known to be greater than limit.
+// Output parameters: the final simplex s[0..n-1], the point v
+// of simplex closest to the origin and its barycentric coordinates.
+static int gjk(
+    const R2Convex& a, const R2Convex& b, double limit,
+    R2GjkSimplex* warm,
+    GjkSupport* s, int& n, R2Vector& v, double* lambda
+) {
+    n = 0;
+    if (warm != 0) {
+        for (int i = 0; i < warm->size; ++i) {
+            GjkSupport p(a, b, warm->direction[i]);
+            bool repeated = false;
+            for (int j = 0; j < n && !repeated; ++j)
+                repeated = (p.w == s[j].w);
+            if (!repeated)
+                s[n++] = p;
+        }
+    }
+    if (n == 0)
+        s[n++] = GjkSupport(a, b, R2Vector(1., 0.));
+
+    int result = GJK_SEPARATED;
+    int maxIterations = 32 + a.size() + b.size();
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        if (closestPoint(s, n, v, lambda)) {
+            result = GJK_OVERLAP;
+            break;
+        }
+        double vv = v * v;
+        if (vv <= R2GRAPH_EPSILON * R2GRAPH_EPSILON) {
+            result = GJK_OVERLAP;
+            break;
+        }
+
+        // The support point in the direction -v: for all points x
+        // of a - b we have x*v >= p.w*v
+        GjkSupport p(a, b, v * (-1.));
+        double vw = v * p.w;
+        if (limit >= 0. && vw > 0. && vw * vw > limit * limit * vv) {
+            result = GJK_BEYOND;
+            break;
+        }
+        if (vv - vw <= R2GRAPH_EPSILON * vv)
+            break;              // No progress: v is the closest point
+        bool repeated = false;
+        for (int j = 0; j < n && !repeated; ++j)
+            repeated = (p.w == s[j].w);
+        if (repeated)
+            break;
+        s[n++] = p;
+        if (iter == maxIterations - 1) {
+            // Do not leave the simplex without v and lambda
+            if (closestPoint(s, n, v, lambda))
+                result = GJK_OVERLAP;
+        }
+    }
+
+    if (warm != 0) {
+        warm->size = n;
+        for (int i = 0; i < n; ++i)
+            warm->direction[i] = s[i].dir;
+    }
+    return result;
+}
+
+double gjkDistance(
+    const R2Convex& a, const R2Convex& b,
+    R2Point& pa, R2Point& pb,
+    R2GjkSimplex* simplex /* = 0 */
+) {
+    GjkSupport s[3];
+    int n;
+    R2Vector v;
+    double lambda[3];
+    int res = gjk(a, b, (-1.), simplex, s, n, v, lambda);
+
+    // The closest points are the combinations of support points
+    // with barycentric coordinates of v
+    R2Vector ca(0., 0.), cb(0., 0.);
+    for (int i = 0; i < n; ++i) {
+        ca += (s[i].pa - s[0].pa) * lambda[i];
+        cb += (s[i].pb - s[0].pb) * lambda[i];
+    }
+    pa = s[0].pa + ca;
+    pb = s[0].pb + cb;
+    if (res == GJK_OVERLAP)
+        return 0.;
+    return v.length();
+}
+
+bool gjkOverlap(
+    const R2Convex& a, const R2Convex& b,
+    R2GjkSimplex* simplex /* = 0 */
+) {
+    return gjkWithin(a, b, 0., simplex);
+}
+
+bool gjkWithin(
+    const R2Convex& a, const R2Convex& b, double r,
+    R2GjkSimplex* simplex /* = 0 */
+) {
+    GjkSupport s[3];
+    int n;
+    R2Vector v;
+    double lambda[3];
+    int res = gjk(a, b, r, simplex, s, n, v, lambda);
+    if (res == GJK_OVERLAP)
+        return true;
+    else if (res == GJK_BEYOND)
+        return false;
+    else
+        return (v.length() <= r + R2GRAPH_EPSILON);
+}
+
+bool epaPenetration(
+    const R2Convex& a, const R2Convex& b,
+    R2Vector& normal, double& depth,
+    R2GjkSimplex* simplex /* = 0 */
+) {
+    GjkSupport s[3];
+    int n;
+    R2Vector v;
+    double lambda[3];
+    if (gjk(a, b, (-1.), simplex, s, n, v, lambda) != GJK_OVERLAP)
+        return false;
+
+    // Initial polygon inside a - b: the simplex extended
+    // to a triangle
+    std::vector<R2Vector> poly;
+    int i;
+    for (i = 0; i < n; ++i)
+        poly.push_back(s[i].w);
+    if (poly.size() == 1) {
+        R2Vector d(1., 0.);
+        R2Vector w = GjkSupport(a, b, d).w;
+        if (w == poly[0])
+            w = GjkSupport(a, b, d * (-1.)).w;
+        if (w == poly[0]) {
+            // a - b is a vertical segment or a point
+            d = R2Vector(0., 1.);
+            w = GjkSupport(a, b, d).w;
+            if (w == poly[0])
+                w = GjkSupport(a, b, d * (-1.)).w;
+            if (w == poly[0]) {
+                normal = d; depth = 0.;
+                return true;
+            }
+        }
+        poly.push_back(w);
+    }
+    if (poly.size() == 2) {
+        R2Vector d = (poly[1] - poly[0]).normal();
+        d.normalize();
+        R2Vector w = GjkSupport(a, b, d).w;
+        if ((w - poly[0]) * d <= R2GRAPH_EPSILON) {
+            d *= (-1.);
+            w = GjkSupport(a, b, d).w;
+            if ((w - poly[0]) * d <= R2GRAPH_EPSILON) {
+                // a - b is a line segment containing the origin
+                normal = d; depth = 0.;
+                return true;
+            }
+        }
+        poly.push_back(w);
+    }
+    // Counterclockwise orientation
+    if (R2Vector::signed_area(poly[1] - poly[0], poly[2] - poly[0]) < 0.) {
+        R2Vector t = poly[1]; poly[1] = poly[2]; poly[2] = t;
+    }
+
+    // Expand the polygon toward the boundary of a - b
+    // through its edge closest to the origin
+    int maxIterations = 32 + a.size() + b.size();
+    for (int iter = 0; ; ++iter) {
+        int m = (int) poly.size();
+        int best = 0;
+        double bestDist = 0.;
+        R2Vector bestNormal;
+        for (i = 0; i < m; ++i) {
+            R2Vector e = poly[i+1 < m? i+1 : 0] - poly[i];
+            R2Vector nrm(e.y, -e.x);            // Outer normal
+            nrm.normalize();
+            double dist = nrm * poly[i];
+            if (i == 0 || dist < bestDist) {
+                best = i; bestDist = dist; bestNormal = nrm;
+            }
+        }
+        R2Vector w = GjkSupport(a, b, bestNormal).w;
+        double dist = bestNormal * w;
+        if (
+            iter >= maxIterations ||
+            dist - bestDist <= R2GRAPH_EPSILON * (1. + fabs(bestDist))
+        ) {
+            normal = bestNormal;
+            depth = (bestDist > 0.? bestDist : 0.);
+            return true;
+        }
+        poly.insert(poly.begin() + best + 1, w);
+    }
+}
@@ -0,0 +1,72 @@
+//
+// File "ConvGjk.h"
+// Distance, overlap test and penetration depth of two convexes
+// (the Gilbert-Johnson-Keerthi and Expanding Polytope algorithms).
+// The support points of convexes are found by
+// R2Convex::extremeVertex in O(log n), so that every iteration
+// costs O(log n + log m).
+// Used classes:
+//      R2Point, R2Vector, R2Convex
+
+#ifndef CONV_GJK_H
+#   define CONV_GJK_H
+
+#include "R2Graph/R2Graph.h"
+#include "R2Conv.h"
+
+//
+// Simplex of the last query, used for warm start of the next
+// query with the same pair of convexes (e.g. in the next frame
+// of simulation). Only the search directions are kept, so that
+// the convexes may move or change between the queries.
+//
+class R2GjkSimplex {
+public:
+    R2Vector    direction[3];
+    int         size;
+
+    R2GjkSimplex():
+        size(0)
+    {}
+
+    void clear() { size = 0; }
+};
+
+// Distance between the convexes a and b (zero, if they intersect).
+// The closest points of a and b are returned in pa, pb (for the
+// intersecting convexes they are a common point, approximately).
+// Throws R2ConvexException, if one of convexes is empty.
+double gjkDistance(
+    const R2Convex& a, const R2Convex& b,
+    R2Point& pa, R2Point& pb,
+    R2GjkSimplex* simplex = 0
+);
+
+// Do the convexes a and b intersect (touching is considered
+// an intersection)?
+bool gjkOverlap(
+    const R2Convex& a, const R2Convex& b,
+    R2GjkSimplex* simplex = 0
+);
+
+// Is the distance between convexes a and b not greater than r?
+// The iterations stop as soon as the answer is known.
+bool gjkWithin(
+    const R2Convex& a, const R2Convex& b, double r,
+    R2GjkSimplex* simplex = 0
+);
+
+// Penetration depth of intersecting convexes: the length of
+// the shortest translation of b that separates it from a.
+// The translation is depth * normal, where normal is the unit
+// vector (b should be moved by it, or a by its opposite).
+// Return value: false, if the convexes do not intersect.
+bool epaPenetration(
+    const R2Convex& a, const R2Convex& b,
+    R2Vector& normal, double& depth,
+    R2GjkSimplex* simplex = 0
+);
+
+#endif
+//
+// End of file "ConvGjk.h"
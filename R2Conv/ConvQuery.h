@@ -0,0 +1,267 @@
+//
+// File "ConvQuery.h"
+// Queries on a convex polygon in O(log n) time:
+//      point location, distance to a point, tangents from a point,
+//      extreme vertex in a direction.
+// The polygon is a sequence of vertices v[0], ..., v[n-1], ordered
+// clockwise (as in R2Polygon) and accessed by operator[], so that
+// both an array of R2Point and R2PointDeq can be used.
+// Used classes:
+//      R2Point, R2Vector, R2Polygon (orientation predicates)
+
+#ifndef CONV_QUERY_H
+#   define CONV_QUERY_H
+
+#include "R2Conv.h"
+
+// Is the element i of a cyclic sequence f(0), ..., f(n-1)
+// a local maximum?
+template <class Compare>
+inline bool cyclicIsMax(int i, int n, const Compare& compare) {
+    int next = (i+1 < n? i+1 : 0);
+    int prev = (i > 0? i-1 : n-1);
+    return (compare(next, i) <= 0 && compare(i, prev) > 0);
+}
+
+// Index of the maximal element of a sequence f(0), ..., f(n-1),
+// which is unimodal on a cycle (it increases from the minimum
+// to the maximum and then decreases). O(log n) comparings.
+// compare(i, j) returns 1, if f(i) > f(j), -1, if f(i) < f(j),
+// and 0, if f(i) == f(j).
+template <class Compare>
+inline int cyclicMax(int n, const Compare& compare) {
+    if (n <= 3) {
+        int best = 0;
+        for (int i = 1; i < n; ++i) {
+            if (compare(i, best) > 0)
+                best = i;
+        }
+        return best;
+    }
+
+    if (cyclicIsMax(0, n, compare))
+        return 0;
+    int lo = 0, hi = n;
+    while (lo + 1 < hi) {
+        int m = (lo + hi) / 2;
+        if (cyclicIsMax(m, n, compare))
+            return m;
+        int loStep = compare(lo+1, lo);
+        int mStep = compare(m+1 < n? m+1 : 0, m);
+        if (
+            loStep > mStep ||
+            (loStep == mStep && loStep == -compare(m, lo))
+        )
+            hi = m;
+        else
+            lo = m;
+    }
+    return lo;
+}
+
+// Compare two vertices as tangent points from the point p.
+// For side == 1, the better vertex leaves the other one to the
+// right (this is the next vertex when wrapping the hull clockwise);
+// for side == -1, to the left. If the three points are collinear,
+// the vertex farther from p is better.
+// The vertices coinciding with p are the worst ones.
+template <class Vertices>
+class R2WrapCompare {
+    const Vertices& m_Vertices;
+    const R2Point&  m_P;
+    int             m_Side;
+public:
+    R2WrapCompare(const Vertices& vertices, const R2Point& p, int side = 1):
+        m_Vertices(vertices),
+        m_P(p),
+        m_Side(side)
+    {}
+
+    int operator()(int i, int j) const {
+        return compare(m_P, m_Vertices[i], m_Vertices[j], m_Side);
+    }
+
+    static int compare(
+        const R2Point& p, const R2Point& q, const R2Point& r,
+        int side = 1
+    ) {
+        if (q == p)
+            return (r == p? 0 : (-1));
+        if (r == p)
+            return 1;
+        // The exact test: the vertices of hull may be collinear
+        // up to R2GRAPH_EPSILON, and then the sequence of compared
+        // vertices would not be unimodal
+        double area = R2Point::signed_area(p, r, q) * side;
+        if (area > 0.)
+            return 1;
+        else if (area < 0.)
+            return (-1);
+        double dq = p.distance(q), dr = p.distance(r);
+        if (dq > dr)
+            return 1;
+        else if (dq < dr)
+            return (-1);
+        else
+            return 0;
+    }
+};
+
+// Compare two vertices by the projection to the direction d
+template <class Vertices>
+class R2DirectionCompare {
+    const Vertices& m_Vertices;
+    const R2Vector& m_Direction;
+public:
+    R2DirectionCompare(const Vertices& vertices, const R2Vector& d):
+        m_Vertices(vertices),
+        m_Direction(d)
+    {}
+
+    int operator()(int i, int j) const {
+        const R2Point& a = m_Vertices[i];
+        const R2Point& b = m_Vertices[j];
+        double fi = a.x*m_Direction.x + a.y*m_Direction.y;
+        double fj = b.x*m_Direction.x + b.y*m_Direction.y;
+        if (fi > fj)
+            return 1;
+        else if (fi < fj)
+            return (-1);
+        else
+            return 0;
+    }
+};
+
+// Distance from the point t to the line segment [a, b]
+inline double segmentDistance(
+    const R2Point& t, const R2Point& a, const R2Point& b
+) {
+    R2Vector v = b - a;
+    double len2 = v * v;
+    if (len2 <= 0.)
+        return t.distance(a);
+    double s = ((t - a) * v) / len2;
+    if (s <= 0.)
+        return t.distance(a);
+    else if (s >= 1.)
+        return t.distance(b);
+    else
+        return t.distance(a + v*s);
+}
+
+// Index of the vertex with maximal projection to the direction d
+template <class Vertices>
+int convexExtremeVertex(const Vertices& v, int n, const R2Vector& d) {
+    return cyclicMax(n, R2DirectionCompare<Vertices>(v, d));
+}
+
+// Does the polygon (n >= 3) contain the point t?
+// The points of boundary are considered inside.
+template <class Vertices>
+bool convexContains(const Vertices& v, int n, const R2Point& t) {
+    const R2Point& v0 = v[0];
+    if (
+        R2Polygon::orientation(v0, v[1], t) > 0 ||
+        R2Polygon::orientation(v0, v[n-1], t) < 0
+    )
+        return false;
+
+    // Find the triangle (v0, v[lo], v[lo+1]) of fan that contains t:
+    // t lies to the right of the ray v0 -> v[lo]
+    int lo = 1, hi = n-1;
+    while (hi - lo > 1) {
+        int m = (lo + hi) / 2;
+        if (R2Polygon::orientation(v0, v[m], t) <= 0)
+            lo = m;
+        else
+            hi = m;
+    }
+    return (R2Polygon::orientation(v[lo], v[lo+1], t) <= 0);
+}
+
+// Tangents to the segment [a, b] (or the point a == b) from
+// the point t: left, right are 0 for a and 1 for b, as returned
+// by convexTangents for the vertices {a, b}
+inline void segmentTangents(
+    const R2Point& a, const R2Point& b, const R2Point& t,
+    int& left, int& right
+) {
+    left = (R2WrapCompare<const R2Point*>::compare(t, b, a, 1) > 0);
+    right = (R2WrapCompare<const R2Point*>::compare(t, b, a, (-1)) > 0);
+}
+
+// Tangents to the polygon from the point t outside it.
+// The polygon lies to the right of the ray from t through v[left]
+// and to the left of the ray from t through v[right].
+template <class Vertices>
+void convexTangents(
+    const Vertices& v, int n, const R2Point& t,
+    int& left, int& right
+) {
+    if (n <= 2) {
+        segmentTangents(v[0], v[n-1], t, left, right);
+        return;
+    }
+    left = cyclicMax(n, R2WrapCompare<Vertices>(v, t, 1));
+    right = cyclicMax(n, R2WrapCompare<Vertices>(v, t, (-1)));
+}
+
+// Distance from the point t to the polygon (n >= 3);
+// zero for the points inside
+template <class Vertices>
+double convexDistance(const Vertices& v, int n, const R2Point& t) {
+    if (convexContains(v, n, t))
+        return 0.;
+
+    // The edges lit from t form a chain from v[right] to v[left].
+    // Going along the chain, the distance to t decreases and
+    // then increases; find the first edge, at which the distance
+    // stops decreasing.
+    int left, right;
+    convexTangents(v, n, t, left, right);
+    int len = left - right;
+    if (len < 0)
+        len += n;
+
+    // The edges adjacent to the tangent vertices: when t is
+    // almost collinear with an edge (up to R2GRAPH_EPSILON),
+    // the tangents may both go to its far end, and the chain
+    // is empty
+    double dist = segmentDistance(t, v[left], v[left+1 < n? left+1 : 0]);
+    double d = segmentDistance(t, v[right > 0? right-1 : n-1], v[right]);
+    if (d < dist)
+        dist = d;
+    if (len == 0)
+        return dist;
+
+    int lo = 0, hi = len - 1;
+    while (lo < hi) {
+        int m = (lo + hi) / 2;
+        int i = right + m;
+        if (i >= n)
+            i -= n;
+        int j = (i+1 < n? i+1 : 0);
+        if ((t - v[j]) * (v[j] - v[i]) > 0.)
+            lo = m + 1;     // Distance decreases along the edge
+        else
+            hi = m;
+    }
+
+    int i = right + lo;
+    if (i >= n)
+        i -= n;
+    d = segmentDistance(t, v[i], v[i+1 < n? i+1 : 0]);
+    if (d < dist)
+        dist = d;
+    if (lo > 0) {
+        int k = (i > 0? i-1 : n-1);
+        d = segmentDistance(t, v[k], v[i]);
+        if (d < dist)
+            dist = d;
+    }
+    return dist;
+}
+
+#endif
+//
+// End of file "ConvQuery.h"
@@ -0,0 +1,356 @@
+//
+// File "DynConv.cpp"
+// Implementation of classes R2HullTree, R2DynamicConvex
+//
+#include <assert.h>
+#include "DynConv.h"
+
+// Cross product of vectors b - a and c - a:
+// positive, if c lies to the left of the line a -> b
+static double cross(const R2Point& a, const R2Point& b, const R2Point& c) {
+    return (b.x - a.x)*(c.y - a.y) - (b.y - a.y)*(c.x - a.x);
+}
+
+void R2HullTree::destroy(Node* v) {
+    if (v == 0)
+        return;
+    destroy(v->left);
+    destroy(v->right);
+    delete v;
+}
+
+unsigned R2HullTree::random() {
+    // Xorshift generator
+    m_Random ^= m_Random << 13;
+    m_Random ^= m_Random >> 17;
+    m_Random ^= m_Random << 5;
+    return m_Random;
+}
+
+void R2HullTree::addPoint(const R2Point& t) {
+    ++m_NumPoints;
+    if (m_Root == 0) {
+        m_Root = new Node(t);
+        return;
+    }
+
+    // Find the leaf
+    Node* v = m_Root;
+    while (!v->isLeaf()) {
+        if (!less(v->left->maxLeaf->point, t))
+            v = v->left;
+        else
+            v = v->right;
+    }
+    if (v->point.x == t.x && v->point.y == t.y) {
+        ++(v->count);           // The hull does not change
+        return;
+    }
+
+    // Replace the leaf by an internal node with two leaves
+    Node* leaf = new Node(t);
+    Node* node = new Node(t);
+    node->priority = random();
+    node->parent = v->parent;
+    if (v->parent == 0)
+        m_Root = node;
+    else if (v->parent->left == v)
+        v->parent->left = node;
+    else
+        v->parent->right = node;
+    if (less(t, v->point)) {
+        node->left = leaf; node->right = v;
+    } else {
+        node->left = v; node->right = leaf;
+    }
+    leaf->parent = node; v->parent = node;
+    update(node);
+
+    // Restore the heap order of priorities
+    while (node->parent != 0 && node->parent->priority < node->priority)
+        rotateUp(node);
+
+    // The nodes below node are up to date. Above the first node,
+    // whose hull does not contain the new point, nothing changes:
+    // the hull is the same as before insertion.
+    bool onHull = true;
+    for (v = leaf->parent; v != node; v = v->parent)
+        onHull = onHull && isHullVertex(v, leaf);
+    for (v = node; v != 0; v = v->parent) {
+        update(v);
+        onHull = onHull && isHullVertex(v, leaf);
+        if (!onHull)
+            break;
+    }
+}
+
+// Is the leaf w (a descendant of the child of v), which is
+// a vertex of the hull of that child, a vertex of the hull of v?
+bool R2HullTree::isHullVertex(const Node* v, const Node* w) {
+    if (!less(v->left->maxLeaf->point, w->point))
+        return (w == v->bridgeLeft || less(w->point, v->bridgeLeft->point));
+    else
+        return (w == v->bridgeRight || less(v->bridgeRight->point, w->point));
+}
+
+bool R2HullTree::removePoint(const R2Point& t) {
+    if (m_Root == 0)
+        return false;
+    Node* v = m_Root;
+    while (!v->isLeaf()) {
+        if (!less(v->left->maxLeaf->point, t))
+            v = v->left;
+        else
+            v = v->right;
+    }
+    if (v->point.x != t.x || v->point.y != t.y)
+        return false;
+
+    --m_NumPoints;
+    if (v->count > 1) {
+        --(v->count);           // The hull does not change
+        return true;
+    }
+
+    // Replace the parent of leaf by its sibling
+    Node* parent = v->parent;
+    if (parent == 0) {
+        delete v;
+        m_Root = 0;
+        return true;
+    }
+
+    // The first node, whose hull does not contain the point:
+    // its hull and the nodes above it do not change
+    Node* stop = parent;
+    while (stop != 0 && isHullVertex(stop, v))
+        stop = stop->parent;
+
+    Node* sibling = (parent->left == v? parent->right : parent->left);
+    delete v;
+    Node* grand = parent->parent;
+    sibling->parent = grand;
+    if (grand == 0)
+        m_Root = sibling;
+    else if (grand->left == parent)
+        grand->left = sibling;
+    else
+        grand->right = sibling;
+    if (stop == parent)
+        stop = grand;
+    delete parent;
+
+    for (v = grand; v != stop; v = v->parent)
+        update(v);
+    return true;
+}
+
+// Rotate the internal node v above its parent
+void R2HullTree::rotateUp(Node* v) {
+    Node* p = v->parent;
+    Node* g = p->parent;
+    if (p->left == v) {
+        p->left = v->right;
+        p->left->parent = p;
+        v->right = p;
+    } else {
+        p->right = v->left;
+        p->right->parent = p;
+        v->left = p;
+    }
+    p->parent = v;
+    v->parent = g;
+    if (g == 0)
+        m_Root = v;
+    else if (g->left == p)
+        g->left = v;
+    else
+        g->right = v;
+    update(p);
+}
+
+// Recompute the bridge and aggregates of an internal node,
+// when its subtrees are up to date. O(log^2 n)
+void R2HullTree::update(Node* v) {
+    if (v->isLeaf())
+        return;
+    v->minLeaf = v->left->minLeaf;
+    v->maxLeaf = v->right->maxLeaf;
+
+    Node* p; Node* q;
+    findBridge(v, p, q);
+    v->bridgeLeft = p;
+    v->bridgeRight = q;
+    v->leftPart = prefix(v->left, p);
+    v->rightPart = v->right->total - prefix(v->right, q);
+    v->total = v->leftPart + Chain(p->point, q->point) + v->rightPart;
+}
+
+// Find the bridge [p, q] between the upper hulls of subtrees of v.
+// We descend simultaneously into the left subtree (node x) and the
+// right subtree (node y), so that p is always in the subtree of x,
+// q in the subtree of y. When the bridge is not unique (collinear
+// points), p is the leftmost and q is the rightmost possible one.
+void R2HullTree::findBridge(Node* v, Node*& p, Node*& q) {
+    Node* x = v->left;
+    Node* y = v->right;
+    while (!x->isLeaf() || !y->isLeaf()) {
+        // [a, b] is an edge of hull of x, [c, d] is an edge of hull of y
+        const R2Point& a = x->bridgeLeft->point;
+        const R2Point& b = x->bridgeRight->point;
+        const R2Point& c = y->bridgeLeft->point;
+        const R2Point& d = y->bridgeRight->point;
+
+        if (x->isLeaf()) {
+            // p == a; q is after [c, d], if a is above the line (c, d)
+            y = (cross(c, d, a) >= 0.? y->right : y->left);
+        } else if (y->isLeaf()) {
+            // q == c; p is before [a, b], if c is above the line (a, b)
+            x = (cross(a, b, c) >= 0.? x->left : x->right);
+        } else if (cross(a, b, c) >= 0. || cross(a, b, d) >= 0.) {
+            x = x->left;        // [c, d] rises above the line (a, b)
+        } else if (cross(c, d, a) >= 0. || cross(c, d, b) >= 0.) {
+            y = y->right;       // [a, b] rises above the line (c, d)
+        } else {
+            // Both edges are below the other line.
+            // If the intersection point of lines (a, b) and (c, d)
+            // is to the left of the subtree y, then p is after [a, b];
+            // otherwise q is before [c, d].
+            R2Vector ab = b - a;
+            R2Vector cd = d - c;
+            double s = R2Vector::signed_area(c - a, cd) /
+                R2Vector::signed_area(ab, cd);
+            double ix = a.x + ab.x * s;
+            if (ix < y->minLeaf->point.x)
+                x = x->right;
+            else
+                y = y->left;
+        }
+    }
+    p = x;
+    q = y;
+}
+
+// Chain of the upper hull of v from its first vertex to the
+// vertex w (a leaf of subtree of v lying on its hull). O(log n)
+R2HullTree::Chain R2HullTree::prefix(const Node* v, const Node* w) {
+    Chain res;
+    while (!v->isLeaf()) {
+        const Node* p = v->bridgeLeft;
+        if (w == p || less(w->point, p->point)) {
+            v = v->left;
+        } else {
+            // Chain of the right subtree from the bridge to w
+            // is prefix(right, w) - prefix(right, bridgeRight)
+            res = res + v->leftPart +
+                Chain(p->point, v->bridgeRight->point) -
+                (v->right->total - v->rightPart);
+            v = v->right;
+        }
+    }
+    return res;
+}
+
+void R2HullTree::vertices(std::vector<R2Point>& v) const {
+    if (m_Root != 0)
+        collect(m_Root, 0, 0, v);
+}
+
+// Append the vertices of the hull of v in the range [lo, hi]
+// of leaves (zero pointer means no bound)
+void R2HullTree::collect(
+    const Node* v, const Node* lo, const Node* hi,
+    std::vector<R2Point>& out
+) {
+    if (
+        (lo != 0 && less(v->maxLeaf->point, lo->point)) ||
+        (hi != 0 && less(hi->point, v->minLeaf->point))
+    )
+        return;                 // The subtree is out of range
+    if (v->isLeaf()) {
+        out.push_back(v->point);
+        return;
+    }
+    const Node* p = v->bridgeLeft;
+    const Node* q = v->bridgeRight;
+    if (lo == 0 || lo == p || less(lo->point, p->point)) {
+        const Node* h = p;
+        if (hi != 0 && less(hi->point, p->point))
+            h = hi;
+        collect(v->left, lo, h, out);
+    }
+    if (hi == 0 || hi == q || less(q->point, hi->point)) {
+        const Node* l = q;
+        if (lo != 0 && less(q->point, lo->point))
+            l = lo;
+        collect(v->right, l, hi, out);
+    }
+}
+
+// End of implementation of the class R2HullTree
+//======================================================
+
+void R2DynamicConvex::addPoint(const R2Point& t) {
+    m_Upper.addPoint(t);
+    m_Lower.addPoint(R2Point(-t.x, -t.y));
+    m_Valid = false;
+}
+
+bool R2DynamicConvex::removePoint(const R2Point& t) {
+    if (!m_Upper.removePoint(t))
+        return false;
+    bool removed = m_Lower.removePoint(R2Point(-t.x, -t.y));
+    assert(removed);
+    m_Valid = false;
+    return removed;
+}
+
+int R2DynamicConvex::size() const {
+    if (m_Upper.empty())
+        return 0;
+    int n = m_Upper.hull().numEdges + m_Lower.hull().numEdges;
+    return (n == 0? 1 : n);
+}
+
+double R2DynamicConvex::area() const {
+    // The upper hull goes from left to right, the lower one
+    // from right to left (the reflection through the origin
+    // does not change the cross products): the whole contour
+    // is clockwise
+    return (-0.5) * (m_Upper.hull().cross + m_Lower.hull().cross);
+}
+
+double R2DynamicConvex::perimeter() const {
+    return m_Upper.hull().length + m_Lower.hull().length;
+}
+
+void R2DynamicConvex::validate() const {
+    if (m_Valid)
+        return;
+    m_Vertices.clear();
+    m_Upper.vertices(m_Vertices);
+    int n = (int) m_Vertices.size();
+    m_Lower.vertices(m_Vertices);
+    // Reflect the lower hull back; its ends coincide with the ends
+    // of upper hull
+    for (int i = n; i < (int) m_Vertices.size(); ++i) {
+        m_Vertices[i].x = (-m_Vertices[i].x);
+        m_Vertices[i].y = (-m_Vertices[i].y);
+    }
+    if (n == 1) {
+        m_Vertices.resize(1);   // The only point
+    } else if (n > 1) {
+        m_Vertices.pop_back();
+        m_Vertices.erase(m_Vertices.begin() + n);
+    }
+    m_Valid = true;
+}
+
+bool R2DynamicConvex::forEach(bool (*action)(const R2Point&)) const {
+    const_iterator e = end();
+    for (const_iterator i = begin(); i != e; ++i) {
+        if ((*action)(*i))
+            return true;
+    }
+    return false;
+}
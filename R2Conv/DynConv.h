@@ -0,0 +1,225 @@
+//
+// File "DynConv.h"
+// Interface of class R2DynamicConvex:
+//      convex hull of a set of points supporting both insertion
+//      and deletion of points in O(log^2 n).
+// Used classes:
+//      R2Point, R2Vector
+
+#ifndef DYN_CONV_H
+#   define DYN_CONV_H
+
+#include <vector>
+#include "R2Graph/R2Graph.h"
+
+//
+// Upper hull of a set of points (Overmars-van Leeuwen).
+// The points are the leaves of a balanced binary tree (treap)
+// in lexicographic order (x, then y). Every internal node keeps
+// the bridge between the upper hulls of its subtrees, so that the
+// hull of a node is the hull of the left subtree up to the bridge,
+// the bridge and the hull of the right subtree after the bridge.
+// The bridge is found by a simultaneous descent into both subtrees.
+// The predicates are exact (no R2GRAPH_EPSILON): the collinear
+// points are never the vertices of hull.
+//
+class R2HullTree {
+public:
+    // Aggregate values of a chain of hull vertices
+    class Chain {
+    public:
+        double  length;     // Sum of lengths of edges
+        double  cross;      // Sum of cross products of edge ends
+        int     numEdges;
+
+        Chain():
+            length(0.),
+            cross(0.),
+            numEdges(0)
+        {}
+
+        Chain(const R2Point& a, const R2Point& b):  // Edge [a, b]
+            length(a.distance(b)),
+            cross(a.x*b.y - a.y*b.x),
+            numEdges(1)
+        {}
+
+        Chain operator+(const Chain& c) const {
+            Chain res;
+            res.length = length + c.length;
+            res.cross = cross + c.cross;
+            res.numEdges = numEdges + c.numEdges;
+            return res;
+        }
+
+        Chain operator-(const Chain& c) const {
+            Chain res;
+            res.length = length - c.length;
+            res.cross = cross - c.cross;
+            res.numEdges = numEdges - c.numEdges;
+            return res;
+        }
+    };
+
+private:
+    class Node {
+    public:
+        Node*       left;
+        Node*       right;
+        Node*       parent;
+        R2Point     point;      // Leaf: the point
+        int         count;      // Leaf: multiplicity of the point
+        unsigned    priority;   // Internal node: priority of treap
+        Node*       minLeaf;    // The leftmost leaf of subtree
+        Node*       maxLeaf;    // The rightmost leaf of subtree
+        Node*       bridgeLeft; // Bridge between hulls of subtrees
+        Node*       bridgeRight;
+        Chain       leftPart;   // Hull of left subtree up to bridge
+        Chain       rightPart;  // Hull of right subtree after bridge
+        Chain       total;      // Hull of the node
+
+        Node(const R2Point& p):     // Leaf
+            left(0),
+            right(0),
+            parent(0),
+            point(p),
+            count(1),
+            priority(0),
+            minLeaf(this),
+            maxLeaf(this),
+            bridgeLeft(this),
+            bridgeRight(this),
+            leftPart(),
+            rightPart(),
+            total()
+        {}
+
+        bool isLeaf() const { return (left == 0); }
+    };
+
+    Node*       m_Root;
+    int         m_NumPoints;
+    unsigned    m_Random;       // State of random generator
+
+public:
+    R2HullTree():
+        m_Root(0),
+        m_NumPoints(0),
+        m_Random(2463534242U)
+    {}
+
+    ~R2HullTree() { destroy(m_Root); }
+
+    void addPoint(const R2Point& t);
+    bool removePoint(const R2Point& t);
+    void clear() { destroy(m_Root); m_Root = 0; m_NumPoints = 0; }
+
+    int numPoints() const { return m_NumPoints; }
+    bool empty() const { return (m_Root == 0); }
+
+    // The whole upper hull
+    Chain hull() const {
+        return (m_Root == 0? Chain() : m_Root->total);
+    }
+
+    // Append the vertices of upper hull to the array (left to right)
+    void vertices(std::vector<R2Point>& v) const;
+
+private:
+    R2HullTree(const R2HullTree&);              // Not implemented
+    R2HullTree& operator=(const R2HullTree&);   // Not implemented
+
+    static void destroy(Node* v);
+    static bool less(const R2Point& p, const R2Point& q) {
+        return (p.x < q.x || (p.x == q.x && p.y < q.y));
+    }
+
+    unsigned random();
+    void rotateUp(Node* v);
+    void update(Node* v);
+    static void findBridge(Node* v, Node*& p, Node*& q);
+    static bool isHullVertex(const Node* v, const Node* w);
+    static Chain prefix(const Node* v, const Node* w);
+    static void collect(
+        const Node* v, const Node* lo, const Node* hi,
+        std::vector<R2Point>& out
+    );
+};
+
+//
+// Convex hull as a pair of upper hulls: the upper one, and
+// the lower one (kept as the upper hull of the points reflected
+// through the origin).
+//
+class R2DynamicConvex {
+    R2HullTree  m_Upper;
+    R2HullTree  m_Lower;
+
+    // Vertices of the hull, computed on demand
+    mutable std::vector<R2Point> m_Vertices;
+    mutable bool                 m_Valid;
+
+public:
+    R2DynamicConvex():
+        m_Upper(),
+        m_Lower(),
+        m_Vertices(),
+        m_Valid(true)
+    {}
+
+    ~R2DynamicConvex() {}
+
+    // Add the point t; the same point may be added several times
+    void addPoint(const R2Point& t);
+
+    // Remove one instance of the point t (compared exactly).
+    // Return value: false, if there is no such point.
+    bool removePoint(const R2Point& t);
+
+    void initialize() {
+        m_Upper.clear(); m_Lower.clear();
+        m_Vertices.clear(); m_Valid = true;
+    }
+
+    // Number of points in the set (with multiplicity)
+    int numPoints() const { return m_Upper.numPoints(); }
+
+    // Number of vertices of the hull
+    int size() const;
+
+    double area() const;
+    double perimeter() const;
+
+    // Vertices of the hull are ordered clockwise, beginning from
+    // the leftmost one (as in R2Convex). Iteration costs O(h log n)
+    // after every change of the set, and O(h) otherwise.
+    typedef const R2Point* const_iterator;
+
+    const_iterator begin() const {
+        validate();
+        return (m_Vertices.empty()? 0 : &(m_Vertices[0]));
+    }
+    const_iterator end() const {
+        validate();
+        return begin() + m_Vertices.size();
+    }
+
+    // Loop for each vertex of convex
+    // Return value: true, if loop was broken
+    // Input parameter:
+    //      pointer to function with const R2Point& parameter,
+    //      this function is to be called for every vertex;
+    //      if this function returns true, then the loop will be
+    //      broken.
+    bool forEach(bool (*action)(const R2Point&)) const;
+
+private:
+    R2DynamicConvex(const R2DynamicConvex&);            // Not implemented
+    R2DynamicConvex& operator=(const R2DynamicConvex&); // Not implemented
+
+    void validate() const;
+};
+
+#endif
+//
+// End of file "DynConv.h"
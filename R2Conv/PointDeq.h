@@ -6,6 +6,7 @@
 #ifndef POINT_DEQ_H
 #define POINT_DEQ_H
 
+#include <assert.h>
 #include "R2Graph/R2Graph.h"
 
 class DeqException {
@@ -22,6 +23,28 @@ public:
 
 const int DEQ_MAXELEM = 1024;
 
+// Contiguous array of points (a part of deq), read only
+class R2PointSpan {
+public:
+    const R2Point*  data;
+    int             length;
+
+    R2PointSpan():
+        data(0),
+        length(0)
+    {}
+
+    R2PointSpan(const R2Point* d, int len):
+        data(d),
+        length(len)
+    {}
+
+    int size() const { return length; }
+    const R2Point* begin() const { return data; }
+    const R2Point* end() const { return data + length; }
+    const R2Point& operator[](int i) const { return data[i]; }
+};
+
 class R2PointDeq {
 private:
     const int   m_MaxElem;
@@ -49,9 +72,22 @@ public:
     {
     }
 
+    // The copy has the same capacity and elements
+    R2PointDeq(const R2PointDeq& d):
+        m_MaxElem(d.m_MaxElem),
+        m_Begin(d.m_Begin),
+        m_End(d.m_End),
+        m_NumElem(d.m_NumElem),
+        m_Elements(new R2Point[d.m_MaxElem])
+    {
+        for (int i = 0, j = m_Begin; i < m_NumElem; ++i, j = nextIndex(j))
+            m_Elements[j] = d.m_Elements[j];
+    }
+
     ~R2PointDeq() { delete[] m_Elements; }
 
 private:
+    R2PointDeq& operator=(const R2PointDeq&);   // Not implemented
 
     int nextIndex(int i) const {
         if (i < m_MaxElem-1) return i+1;
@@ -122,6 +158,87 @@ public:
         return m_Elements[m_End];
     }
 
+    // Unchecked access, for the algorithms whose invariants
+    // guarantee that the deq is not empty (for pops and front/back)
+    // or not full (for pushes). The conditions are checked only
+    // by assert, so that with NDEBUG there are neither branches
+    // nor exceptions.
+
+    void uncheckedPushFront(const R2Point& p) {
+        assert(m_NumElem < m_MaxElem);
+        m_Begin = prevIndex(m_Begin);
+        m_Elements[m_Begin] = p;
+        ++m_NumElem;
+    }
+
+    void uncheckedPushBack(const R2Point& p) {
+        assert(m_NumElem < m_MaxElem);
+        m_End = nextIndex(m_End);
+        m_Elements[m_End] = p;
+        ++m_NumElem;
+    }
+
+    R2Point uncheckedPopFront() {
+        assert(m_NumElem > 0);
+        int i = m_Begin;
+        m_Begin = nextIndex(m_Begin);
+        --m_NumElem;
+        return m_Elements[i];
+    }
+
+    R2Point uncheckedPopBack() {
+        assert(m_NumElem > 0);
+        int i = m_End;
+        m_End = prevIndex(m_End);
+        --m_NumElem;
+        return m_Elements[i];
+    }
+
+    R2Point& uncheckedFront() const {
+        assert(m_NumElem > 0);
+        return m_Elements[m_Begin];
+    }
+
+    R2Point& uncheckedBack() const {
+        assert(m_NumElem > 0);
+        return m_Elements[m_End];
+    }
+
+    // Move the front element to the back (rotation of a ring)
+    void rotate() {
+        assert(m_NumElem > 0);
+        R2Point p = m_Elements[m_Begin];
+        m_Begin = nextIndex(m_Begin);
+        m_End = nextIndex(m_End);
+        m_Elements[m_End] = p;
+    }
+
+    // Indexed access without bounds check, for the templates
+    // of "ConvQuery.h": m_Deq.unchecked()[i]
+    class UncheckedIndex {
+        const R2Point*  m_Elements;
+        int             m_Begin;
+        int             m_MaxElem;
+        int             m_NumElem;
+    public:
+        UncheckedIndex(const R2PointDeq& d):
+            m_Elements(d.m_Elements),
+            m_Begin(d.m_Begin),
+            m_MaxElem(d.m_MaxElem),
+            m_NumElem(d.m_NumElem)
+        {}
+
+        const R2Point& operator[](int i) const {
+            assert(i >= 0 && i < m_NumElem);
+            i += m_Begin;
+            if (i >= m_MaxElem)
+                i -= m_MaxElem;
+            return m_Elements[i];
+        }
+    };
+
+    UncheckedIndex unchecked() const { return UncheckedIndex(*this); }
+
     void clear() {
         m_Begin = 0;
         m_End = m_MaxElem-1;
@@ -131,6 +248,31 @@ public:
     int size() const { return m_NumElem; }
     int maxSize() const { return m_MaxElem; }
 
+    // Element at position i from the front of deq, i = 0..size()-1
+    const R2Point& operator[](int i) const {
+        if (i < 0 || i >= m_NumElem)
+            throw DeqException("Index out of bounds");
+        i += m_Begin;
+        if (i >= m_MaxElem)
+            i -= m_MaxElem;
+        return m_Elements[i];
+    }
+
+    // The elements of deq from front to back as at most two
+    // contiguous arrays (the deq is a ring buffer, so the sequence
+    // may wrap around the end of buffer).
+    // Return value: the number of nonempty spans (0, 1 or 2).
+    int spans(R2PointSpan& first, R2PointSpan& second) const {
+        int len = m_MaxElem - m_Begin;
+        if (len > m_NumElem)
+            len = m_NumElem;
+        first = R2PointSpan(m_Elements + m_Begin, len);
+        second = R2PointSpan(m_Elements, m_NumElem - len);
+        if (m_NumElem == 0)
+            return 0;
+        return (second.length > 0? 2 : 1);
+    }
+
     class iterator {
         R2PointDeq* deq;
         int current;
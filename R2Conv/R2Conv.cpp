@@ -4,9 +4,14 @@
 //
 #include <stdlib.h>
 #include <assert.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <algorithm>
 #include "R2Conv.h"
+#include "ConvQuery.h"
 
-void R2Convex::addPoint(const R2Point& t) {
+bool R2Convex::addPoint(const R2Point& t) {
     if (m_NumAng == 0) {
         ++m_NumAng;
         m_A = t;
@@ -14,6 +19,8 @@ void R2Convex::addPoint(const R2Point& t) {
         if (t != m_A) {
             ++m_NumAng;
             m_B = t;
+        } else {
+            return false;
         }
     } else if (m_NumAng == 2) {
         if (!R2Point::on_line(m_A, m_B, t)) {
@@ -27,12 +34,27 @@ void R2Convex::addPoint(const R2Point& t) {
         } else if (m_A.between(t, m_B)) {
             // A between t and B
             m_A = t;
+        } else {
+            return false;
         }
     } else {
         assert(m_NumAng >= 3);
         // Pass the request to polygon
-        m_Polygon->addPoint(t);
+        return m_Polygon->addPoint(t);
     }
+    return true;
+}
+
+R2Convex& R2Convex::operator=(const R2Convex& c) {
+    if (this != &c) {
+        R2Polygon* p = (c.m_Polygon == 0? 0 : new R2Polygon(*c.m_Polygon));
+        delete m_Polygon;
+        m_Polygon = p;
+        m_A = c.m_A;
+        m_B = c.m_B;
+        m_NumAng = c.m_NumAng;
+    }
+    return *this;
 }
 
 // Loop for every vertex of convex
@@ -57,6 +79,575 @@ bool R2Convex::forEach(bool (*action)(R2Point&)) {
     }
 }
 
+void R2Convex::assign(const R2Point* vertices, int numVertices) {
+    if (numVertices < 3) {
+        delete m_Polygon; m_Polygon = 0;
+        m_NumAng = numVertices;
+        if (numVertices > 0)
+            m_A = vertices[0];
+        if (numVertices > 1)
+            m_B = vertices[1];
+    } else {
+        if (m_Polygon != 0 && m_Polygon->maxSize() >= numVertices) {
+            // Reuse the deq of polygon
+            m_Polygon->assign(vertices, numVertices);
+        } else {
+            delete m_Polygon;
+            m_Polygon = new R2Polygon(vertices, numVertices);
+        }
+        m_NumAng = 3;
+    }
+}
+
+void R2Convex::assign(
+    const R2Point* vertices, int numVertices,
+    double area, double perimeter
+) {
+    if (numVertices < 3) {
+        assign(vertices, numVertices);
+    } else {
+        if (m_Polygon != 0 && m_Polygon->maxSize() >= numVertices) {
+            m_Polygon->assign(vertices, numVertices, area, perimeter);
+        } else {
+            delete m_Polygon;
+            m_Polygon = new R2Polygon(
+                vertices, numVertices, area, perimeter
+            );
+        }
+        m_NumAng = 3;
+    }
+}
+
+bool R2Convex::contains(const R2Point& t) const {
+    if (m_NumAng == 0)
+        return false;
+    else if (m_NumAng == 1)
+        return (t == m_A);
+    else if (m_NumAng == 2)
+        return t.between(m_A, m_B);
+    else
+        return m_Polygon->contains(t);
+}
+
+double R2Convex::distance(const R2Point& t) const {
+    if (m_NumAng == 0)
+        throw R2ConvexException("Empty convex");
+    else if (m_NumAng == 1)
+        return t.distance(m_A);
+    else if (m_NumAng == 2)
+        return segmentDistance(t, m_A, m_B);
+    else
+        return m_Polygon->distance(t);
+}
+
+bool R2Convex::tangents(
+    const R2Point& t, R2Point& left, R2Point& right
+) const {
+    if (m_NumAng == 0 || contains(t))
+        return false;
+    if (m_NumAng < 3) {
+        const R2Point& b = (m_NumAng == 2? m_B : m_A);
+        int l, r;
+        segmentTangents(m_A, b, t, l, r);
+        left = (l == 0? m_A : b);
+        right = (r == 0? m_A : b);
+    } else {
+        m_Polygon->tangents(t, left, right);
+    }
+    return true;
+}
+
+R2Point R2Convex::extremeVertex(const R2Vector& d) const {
+    if (m_NumAng == 0)
+        throw R2ConvexException("Empty convex");
+    else if (m_NumAng == 1)
+        return m_A;
+    else if (m_NumAng == 2)
+        return ((m_B - m_A) * d > 0.? m_B : m_A);
+    else
+        return m_Polygon->extremeVertex(d);
+}
+
+//
+// Chan's algorithm
+//
+
+// Lexicographic order of points (x, then y)
+static bool lessXY(const R2Point& p, const R2Point& q) {
+    return (p.x < q.x || (p.x == q.x && p.y < q.y));
+}
+
+// Convex hull of points[0..n-1] sorted lexicographically
+// (the scan of Andrew's monotone chain algorithm, O(n)).
+// The turns are tested exactly: with R2GRAPH_EPSILON, the vertices
+// of a densely sampled curve are popped one after another, and
+// the hull shrinks.
+// The hull array must have room for 2*n points. Vertices are
+// written clockwise, beginning from the leftmost point.
+// Return value: number of vertices of the hull.
+static int scanSorted(const R2Point* points, int n, R2Point* hull) {
+    if (n <= 0)
+        return 0;
+
+    int i, k = 0;
+    // Upper chain from left to right
+    for (i = 0; i < n; ++i) {
+        while (
+            k >= 2 &&
+            R2Point::signed_area(hull[k-2], hull[k-1], points[i]) >= 0.
+        )
+            --k;
+        hull[k++] = points[i];
+    }
+    // Lower chain from right to left
+    int lower = k + 1;
+    for (i = n - 2; i >= 0; --i) {
+        while (
+            k >= lower &&
+            R2Point::signed_area(hull[k-2], hull[k-1], points[i]) >= 0.
+        )
+            --k;
+        hull[k++] = points[i];
+    }
+    if (k > 1)
+        --k;    // The last point repeats the first one
+
+    // Remove coinciding vertices
+    int m = 1;
+    for (i = 1; i < k; ++i) {
+        if (hull[i] != hull[m-1])
+            hull[m++] = hull[i];
+    }
+    while (m > 1 && hull[m-1] == hull[0])
+        --m;
+    return m;
+}
+
+// Convex hull of points[0..n-1] (Andrew's monotone chain).
+// The array points is sorted in place; the hull array must
+// have room for 2*n points. Vertices are written clockwise,
+// beginning from the leftmost point.
+// Return value: number of vertices of the hull.
+static int monotoneChain(R2Point* points, int n, R2Point* hull) {
+    if (n <= 0)
+        return 0;
+    std::sort(points, points + n, lessXY);
+    return scanSorted(points, n, hull);
+}
+
+// Akl-Toussaint heuristic: copy to the array survivors the points
+// that do not lie strictly inside the convex polygon spanned by
+// the extreme points in 8 directions (along axes and diagonals).
+// Such points cannot be the vertices of the convex hull.
+static void aklToussaint(
+    const R2Point* points, int numPoints,
+    std::vector<R2Point>& survivors
+) {
+    // Extreme points for directions -x, -x+y, y, x+y, x, x-y, -y, -x-y
+    // (clockwise)
+    int ext[8];
+    int i, k;
+    for (k = 0; k < 8; ++k)
+        ext[k] = 0;
+    for (i = 1; i < numPoints; ++i) {
+        const R2Point& p = points[i];
+        if (p.x < points[ext[0]].x) ext[0] = i;
+        if (p.y - p.x > points[ext[1]].y - points[ext[1]].x) ext[1] = i;
+        if (p.y > points[ext[2]].y) ext[2] = i;
+        if (p.x + p.y > points[ext[3]].x + points[ext[3]].y) ext[3] = i;
+        if (p.x > points[ext[4]].x) ext[4] = i;
+        if (p.x - p.y > points[ext[5]].x - points[ext[5]].y) ext[5] = i;
+        if (p.y < points[ext[6]].y) ext[6] = i;
+        if (p.x + p.y < points[ext[7]].x + points[ext[7]].y) ext[7] = i;
+    }
+
+    // Clockwise polygon of extreme points
+    R2Point poly[8];
+    int n = 0;
+    for (k = 0; k < 8; ++k) {
+        const R2Point& p = points[ext[k]];
+        if (n == 0 || p != poly[n-1])
+            poly[n++] = p;
+    }
+    while (n > 1 && poly[n-1] == poly[0])
+        --n;
+
+    survivors.clear();
+    if (n < 3) {
+        survivors.assign(points, points + numPoints);
+        return;
+    }
+    for (i = 0; i < numPoints; ++i) {
+        const R2Point& p = points[i];
+        bool inside = true;
+        for (k = 0; inside && k < n; ++k) {
+            inside = (
+                R2Polygon::orientation(poly[k], poly[k+1 < n? k+1 : 0], p) < 0
+            );
+        }
+        if (!inside)
+            survivors.push_back(p);
+    }
+}
+
+void R2Convex::build(const R2Point* points, int numPoints) {
+    if (numPoints <= 0) {
+        initialize();
+        return;
+    }
+
+    // Throw away the points that are obviously inside the hull
+    std::vector<R2Point> candidates;
+    aklToussaint(points, numPoints, candidates);
+    points = &(candidates[0]);
+    numPoints = (int) candidates.size();
+
+    std::vector<R2Point> group;     // Current group of points
+    std::vector<R2Point> groupHull; // Its convex hull
+    std::vector<R2Point> hulls;     // Hulls of all groups
+    std::vector<int> offsets;       // Beginnings of hulls of groups
+    std::vector<R2Point> result;    // Vertices of the convex hull
+
+    // The leftmost point is a vertex of the convex hull
+    int first = 0;
+    int i;
+    for (i = 1; i < numPoints; ++i) {
+        if (lessXY(points[i], points[first]))
+            first = i;
+    }
+
+    // Group size m = 2^(2^t), t = 1, 2, ..., until m >= h
+    for (int t = 1; ; ++t) {
+        int m = numPoints;
+        if (t < 5 && (1 << (1 << t)) < numPoints)
+            m = (1 << (1 << t));
+
+        // Compute the convex hulls of groups of m points
+        group.resize(m);
+        groupHull.resize(2*m);
+        hulls.clear();
+        offsets.clear();
+        for (int g = 0; g < numPoints; g += m) {
+            int len = std::min(m, numPoints - g);
+            std::copy(points + g, points + g + len, group.begin());
+            int k = monotoneChain(&(group[0]), len, &(groupHull[0]));
+            offsets.push_back((int) hulls.size());
+            hulls.insert(hulls.end(), groupHull.begin(), groupHull.begin() + k);
+        }
+        offsets.push_back((int) hulls.size());
+
+        if (m == numPoints) {
+            // The only group: its hull is the result
+            result.swap(hulls);
+            break;
+        }
+
+        // Jarvis march: at most m steps, O(log m) per group
+        int numGroups = (int) offsets.size() - 1;
+        result.clear();
+        result.push_back(points[first]);
+        bool closed = false;
+        for (int step = 0; step < m; ++step) {
+            R2Point p = result.back();
+            const R2Point* best = 0;
+            for (int g = 0; g < numGroups; ++g) {
+                const R2Point* vertices = &(hulls[offsets[g]]);
+                int n = offsets[g+1] - offsets[g];
+                int j = cyclicMax(
+                    n, R2WrapCompare<const R2Point*>(vertices, p)
+                );
+                if (vertices[j] == p)
+                    continue;
+                if (
+                    best == 0 ||
+                    R2WrapCompare<const R2Point*>::compare(
+                        p, vertices[j], *best
+                    ) > 0
+                )
+                    best = vertices + j;
+            }
+            if (best == 0 || *best == result[0]) {
+                closed = true;
+                break;
+            }
+            result.push_back(*best);
+        }
+        if (closed)
+            break;
+    }
+
+    assign(&(result[0]), (int) result.size());
+}
+
+//
+// Operations on two convexes in O(n + m)
+//
+
+// Split the vertices of convex into the upper and lower chains.
+// Both chains go from the lexicographically smallest vertex to
+// the largest one, so that they are sorted lexicographically.
+static void convexChains(
+    const R2Convex& c,
+    std::vector<R2Point>& upper, std::vector<R2Point>& lower
+) {
+    std::vector<R2Point> v;
+    R2PointSpan span[2];
+    int numSpans = c.spans(span[0], span[1]);
+    for (int k = 0; k < numSpans; ++k)
+        v.insert(v.end(), span[k].begin(), span[k].end());
+    upper.clear(); lower.clear();
+    int n = (int) v.size();
+    if (n == 0)
+        return;
+    int first = 0, last = 0;
+    int i;
+    for (i = 1; i < n; ++i) {
+        if (lessXY(v[i], v[first]))
+            first = i;
+        if (lessXY(v[last], v[i]))
+            last = i;
+    }
+    // The vertices go clockwise: the upper chain follows them
+    for (i = first; ; i = (i+1 < n? i+1 : 0)) {
+        upper.push_back(v[i]);
+        if (i == last)
+            break;
+    }
+    for (i = first; ; i = (i > 0? i-1 : n-1)) {
+        lower.push_back(v[i]);
+        if (i == last)
+            break;
+    }
+}
+
+// Value at x of the piecewise linear function given by a chain
+// with increasing x. The segment index i is advanced
+// monotonically, so that the successive calls with increasing x
+// take O(1) amortized time.
+static double chainValue(const std::vector<R2Point>& c, int& i, double x) {
+    int n = (int) c.size();
+    while (i+2 < n && c[i+1].x < x)
+        ++i;
+    if (i+1 >= n || x <= c[i].x)
+        return c[i].y;
+    if (x >= c[i+1].x)
+        return c[i+1].y;
+    double s = (x - c[i].x) / (c[i+1].x - c[i].x);
+    return c[i].y + (c[i+1].y - c[i].y) * s;
+}
+
+// The abscissas of vertices of chains f, g in the range [lo, hi]
+// (including lo and hi) in increasing order
+static void breakpoints(
+    const std::vector<R2Point>& f, const std::vector<R2Point>& g,
+    double lo, double hi, std::vector<double>& xs
+) {
+    xs.clear();
+    xs.push_back(lo);
+    int i = 0, j = 0;
+    int n = (int) f.size(), m = (int) g.size();
+    while (i < n || j < m) {
+        double x;
+        if (j >= m || (i < n && f[i].x <= g[j].x))
+            x = f[i++].x;
+        else
+            x = g[j++].x;
+        if (x > xs.back() && x < hi)
+            xs.push_back(x);
+    }
+    if (hi > xs.back())
+        xs.push_back(hi);
+}
+
+// Minimum (upper == true) or maximum of the piecewise linear
+// functions f, g on the range [lo, hi]. The vertices of result
+// are the vertices of f and g, and the crossings of f and g.
+static void envelope(
+    const std::vector<R2Point>& f, const std::vector<R2Point>& g,
+    double lo, double hi, bool upper,
+    std::vector<R2Point>& out
+) {
+    std::vector<double> xs;
+    breakpoints(f, g, lo, hi, xs);
+    out.clear();
+    int i = 0, j = 0;
+    double x0 = 0., f0 = 0., d0 = 0.;
+    for (int k = 0; k < (int) xs.size(); ++k) {
+        double x = xs[k];
+        double fx = chainValue(f, i, x);
+        double gx = chainValue(g, j, x);
+        double d = fx - gx;
+        if (k > 0 && ((d0 < 0. && d > 0.) || (d0 > 0. && d < 0.))) {
+            double s = d0 / (d0 - d);
+            out.push_back(R2Point(x0 + (x - x0)*s, f0 + (fx - f0)*s));
+        }
+        if ((d <= 0.) == upper)
+            out.push_back(R2Point(x, fx));
+        else
+            out.push_back(R2Point(x, gx));
+        x0 = x; f0 = fx; d0 = d;
+    }
+}
+
+// Remove the vertical edges at the ends of the chains, so that
+// they become graphs of functions
+static void stripVertical(
+    std::vector<R2Point>& upper, std::vector<R2Point>& lower
+) {
+    if (upper.size() >= 2 && upper[0].x == upper[1].x)
+        upper.erase(upper.begin());
+    int n = (int) lower.size();
+    if (n >= 2 && lower[n-2].x == lower[n-1].x)
+        lower.pop_back();
+}
+
+// The largest absolute value of coordinates of the chain
+static double chainMagnitude(const std::vector<R2Point>& c) {
+    double m = 0.;
+    for (size_t i = 0; i < c.size(); ++i)
+        m = std::max(m, std::max(fabs(c[i].x), fabs(c[i].y)));
+    return m;
+}
+
+// Replace the convex by the convex hull of the lexicographically
+// sorted sequences of points a and b
+void R2Convex::assignHull(
+    const std::vector<R2Point>& a, const std::vector<R2Point>& b
+) {
+    std::vector<R2Point> points(a.size() + b.size());
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), points.begin(), lessXY);
+    int n = (int) points.size();
+    if (n == 0) {
+        initialize();
+        return;
+    }
+    std::vector<R2Point> hull(2*n);
+    int k = scanSorted(&(points[0]), n, &(hull[0]));
+    assign(&(hull[0]), k);
+}
+
+void R2Convex::intersection(const R2Convex& a, const R2Convex& b) {
+    std::vector<R2Point> upperA, lowerA, upperB, lowerB;
+    convexChains(a, upperA, lowerA);
+    convexChains(b, upperB, lowerB);
+    if (upperA.empty() || upperB.empty()) {
+        initialize();
+        return;
+    }
+    stripVertical(upperA, lowerA);
+    stripVertical(upperB, lowerB);
+
+    // The common range of x
+    double lo = std::max(lowerA.front().x, lowerB.front().x);
+    double hi = std::min(upperA.back().x, upperB.back().x);
+    if (lo > hi) {
+        initialize();
+        return;
+    }
+
+    // The intersection is the set of points between the minimum
+    // of upper chains and the maximum of lower chains
+    std::vector<R2Point> upper, lower;
+    envelope(upperA, upperB, lo, hi, true, upper);
+    envelope(lowerA, lowerB, lo, hi, false, lower);
+
+    // The difference of upper and lower envelopes is concave:
+    // keep the range where it is nonnegative up to the rounding
+    // errors, so that a line segment lying on the boundary of
+    // the other convex is not lost. The tolerance bounds the errors
+    // of chainValue and of the vertices computed on a line (which
+    // is not steep); it is proportional to the largest coordinate,
+    // so that the convexes separated by a small gap do not
+    // intersect at any scale.
+    double tolerance = 16. * DBL_EPSILON * std::max(
+        std::max(chainMagnitude(upperA), chainMagnitude(lowerA)),
+        std::max(chainMagnitude(upperB), chainMagnitude(lowerB))
+    );
+    std::vector<double> xs;
+    breakpoints(upper, lower, lo, hi, xs);
+    std::vector<R2Point> top, bottom;
+    int i = 0, j = 0;
+    double x0 = 0., u0 = 0., d0 = 0.;
+    for (int k = 0; k < (int) xs.size(); ++k) {
+        double x = xs[k];
+        double u = chainValue(upper, i, x);
+        double l = chainValue(lower, j, x);
+        double d = u - l + tolerance;
+        if (k > 0 && ((d0 < 0. && d > 0.) || (d0 > 0. && d < 0.))) {
+            double s = d0 / (d0 - d);
+            top.push_back(R2Point(x0 + (x - x0)*s, u0 + (u - u0)*s));
+        }
+        if (d >= 0.) {
+            top.push_back(R2Point(x, u));
+            bottom.push_back(R2Point(x, l));
+        }
+        x0 = x; u0 = u; d0 = d;
+    }
+    assignHull(bottom, top);
+}
+
+void R2Convex::unionHull(const R2Convex& a, const R2Convex& b) {
+    std::vector<R2Point> upperA, lowerA, upperB, lowerB;
+    convexChains(a, upperA, lowerA);
+    convexChains(b, upperB, lowerB);
+
+    // All the vertices of a and b in lexicographic order
+    std::vector<R2Point> pointsA(upperA.size() + lowerA.size());
+    std::merge(
+        upperA.begin(), upperA.end(), lowerA.begin(), lowerA.end(),
+        pointsA.begin(), lessXY
+    );
+    std::vector<R2Point> pointsB(upperB.size() + lowerB.size());
+    std::merge(
+        upperB.begin(), upperB.end(), lowerB.begin(), lowerB.end(),
+        pointsB.begin(), lessXY
+    );
+    assignHull(pointsA, pointsB);
+}
+
+// Minkowski sum of two chains: the edges are merged in order
+// of their directions. For the upper chains the direction turns
+// clockwise, for the lower ones counterclockwise.
+static void chainSum(
+    const std::vector<R2Point>& f, const std::vector<R2Point>& g,
+    bool upper, std::vector<R2Point>& out
+) {
+    out.clear();
+    int n = (int) f.size(), m = (int) g.size();
+    int i = 0, j = 0;
+    out.push_back(R2Point(f[0].x + g[0].x, f[0].y + g[0].y));
+    while (i < n-1 || j < m-1) {
+        bool takeF;
+        if (i >= n-1) {
+            takeF = false;
+        } else if (j >= m-1) {
+            takeF = true;
+        } else {
+            double c = R2Vector::signed_area(f[i+1] - f[i], g[j+1] - g[j]);
+            takeF = (upper? c <= 0. : c >= 0.);
+        }
+        if (takeF)
+            ++i;
+        else
+            ++j;
+        out.push_back(R2Point(f[i].x + g[j].x, f[i].y + g[j].y));
+    }
+}
+
+void R2Convex::minkowskiSum(const R2Convex& a, const R2Convex& b) {
+    std::vector<R2Point> upperA, lowerA, upperB, lowerB;
+    convexChains(a, upperA, lowerA);
+    convexChains(b, upperB, lowerB);
+    if (upperA.empty() || upperB.empty()) {
+        initialize();
+        return;
+    }
+    std::vector<R2Point> upper, lower;
+    chainSum(upperA, upperB, true, upper);
+    chainSum(lowerA, lowerB, false, lower);
+    assignHull(lower, upper);
+}
+
 // End of implementation of the class R2Convex
 //======================================================
 
@@ -87,49 +678,128 @@ R2Polygon::R2Polygon(
     m_Area = R2Point::area(a, b, c);
 }
 
-void R2Polygon::addPoint(const R2Point& t) {
+R2Polygon::R2Polygon(const R2Point* vertices, int numVertices):
+    m_Deq(
+        2*numVertices > DEQ_MAXELEM? 2*numVertices : DEQ_MAXELEM
+    ),
+    m_Area(0.),
+    m_Perimeter(0.)
+{
+    assign(vertices, numVertices);
+}
+
+R2Polygon::R2Polygon(
+    const R2Point* vertices, int numVertices,
+    double area, double perimeter
+):
+    m_Deq(
+        2*numVertices > DEQ_MAXELEM? 2*numVertices : DEQ_MAXELEM
+    ),
+    m_Area(0.),
+    m_Perimeter(0.)
+{
+    assign(vertices, numVertices, area, perimeter);
+}
+
+void R2Polygon::assign(const R2Point* vertices, int numVertices) {
+    assert(numVertices >= 3 && numVertices <= m_Deq.maxSize());
+
+    m_Deq.clear();
+    m_Area = 0.;
+    m_Perimeter = 0.;
+    for (int i = 0; i < numVertices; ++i) {
+        const R2Point& a = vertices[i];
+        const R2Point& b = vertices[i+1 < numVertices? i+1 : 0];
+        m_Deq.pushBack(a);
+        m_Perimeter += a.distance(b);
+        if (i > 0 && i < numVertices-1)
+            m_Area += R2Point::area(vertices[0], a, b);
+    }
+}
+
+void R2Polygon::assign(
+    const R2Point* vertices, int numVertices,
+    double area, double perimeter
+) {
+    assert(numVertices >= 3 && numVertices <= m_Deq.maxSize());
+
+    m_Deq.clear();
+    for (int i = 0; i < numVertices; ++i)
+        m_Deq.uncheckedPushBack(vertices[i]);
+    m_Area = area;
+    m_Perimeter = perimeter;
+}
+
+bool R2Polygon::addPoint(const R2Point& t) {
     int i; R2Point x;
 
+    // The polygon has at least 3 vertices, and t cannot light all
+    // its edges: the unchecked operations of deq are safe, except
+    // the final push of t, which may overflow the deq.
+
     int num = m_Deq.size();    // Number of vertices
 
     // Try to find the lit edge
     for (i = 0; i < num; ++i) {
-        if (lit(m_Deq.back(), m_Deq.front(), t))
+        if (lit(m_Deq.uncheckedBack(), m_Deq.uncheckedFront(), t))
             break;
         // Rotate the polygon
-        m_Deq.pushBack(
-            m_Deq.popFront()
-        );
+        m_Deq.rotate();
     }
 
     // If current edge is not lit, then nothing to do :-)
-    if (!lit(m_Deq.back(), m_Deq.front(), t))
-        return;
+    if (i >= num)
+        return false;
 
     // Assertion: current edge is lit from the point t.
 
     // Delete the current edge (i.e. modify m_Area and m_Perimeter)
-    remove(m_Deq.back(), m_Deq.front(), t);
+    remove(m_Deq.uncheckedBack(), m_Deq.uncheckedFront(), t);
 
     // Delete lit edges from the beginning of deq
-    x = m_Deq.popFront();
-    while (lit(x, m_Deq.front(), t)) {
-        remove(x, m_Deq.front(), t);
-        x = m_Deq.popFront();
+    x = m_Deq.uncheckedPopFront();
+    while (lit(x, m_Deq.uncheckedFront(), t)) {
+        remove(x, m_Deq.uncheckedFront(), t);
+        x = m_Deq.uncheckedPopFront();
     }
-    m_Deq.pushFront(x);
+    m_Deq.uncheckedPushFront(x);
 
     // Delete lit edges from the end of deq
-    x = m_Deq.popBack();
-    while (lit(m_Deq.back(), x, t)) {
-        remove(m_Deq.back(), x, t);
-        x = m_Deq.popBack();
+    x = m_Deq.uncheckedPopBack();
+    while (lit(m_Deq.uncheckedBack(), x, t)) {
+        remove(m_Deq.uncheckedBack(), x, t);
+        x = m_Deq.uncheckedPopBack();
     }
-    m_Deq.pushBack(x);
+    m_Deq.uncheckedPushBack(x);
 
-    m_Perimeter += m_Deq.front().distance(t) + t.distance(m_Deq.back());
+    m_Perimeter +=
+        m_Deq.uncheckedFront().distance(t) +
+        t.distance(m_Deq.uncheckedBack());
 
     m_Deq.pushFront(t);
+    return true;
+}
+
+bool R2Polygon::contains(const R2Point& t) const {
+    return convexContains(m_Deq.unchecked(), m_Deq.size(), t);
+}
+
+double R2Polygon::distance(const R2Point& t) const {
+    return convexDistance(m_Deq.unchecked(), m_Deq.size(), t);
+}
+
+void R2Polygon::tangents(
+    const R2Point& t, R2Point& left, R2Point& right
+) const {
+    int l, r;
+    R2PointDeq::UncheckedIndex v = m_Deq.unchecked();
+    convexTangents(v, m_Deq.size(), t, l, r);
+    left = v[l]; right = v[r];
+}
+
+const R2Point& R2Polygon::extremeVertex(const R2Vector& d) const {
+    R2PointDeq::UncheckedIndex v = m_Deq.unchecked();
+    return v[convexExtremeVertex(v, m_Deq.size(), d)];
 }
 
 void R2Polygon::remove(const R2Point& a, const R2Point& b, const R2Point& t) {
@@ -155,9 +825,7 @@ bool R2Polygon::forEach(bool (*action)(R2Point&)) {
             return true;                //   Break loop, if action returns 1
 
         // Rotate deq
-        m_Deq.pushBack(
-            m_Deq.popFront()
-        );
+        m_Deq.rotate();
     }
     return false;
 }
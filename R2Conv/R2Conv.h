@@ -9,6 +9,7 @@
 #   define CONV_H
 
 #include <math.h>
+#include <vector>
 #include "R2Graph/R2Graph.h"
 #include "PointDeq.h"
 
@@ -40,6 +41,17 @@ public:
         const R2Point& c
     );
 
+    // Polygon with given vertices.
+    // The vertices must be ordered clockwise (as in the deq)
+    // and form a strictly convex polygon
+    R2Polygon(const R2Point* vertices, int numVertices);
+
+    // The same with known area and perimeter (see assign below)
+    R2Polygon(
+        const R2Point* vertices, int numVertices,
+        double area, double perimeter
+    );
+
     ~R2Polygon()
     {
     }
@@ -52,9 +64,29 @@ public:
         return m_Perimeter;
     }
 
-    void addPoint(const R2Point& t);
+    // Return value: true, if the polygon changed (t is outside it)
+    bool addPoint(const R2Point& t);
+
+    // Replace the polygon by another one with given vertices
+    // (ordered clockwise, strictly convex); area and perimeter
+    // are computed from the vertices
+    void assign(const R2Point* vertices, int numVertices);
+
+    // The same with known area and perimeter (e.g. stored in a file):
+    // only the vertices are copied
+    void assign(
+        const R2Point* vertices, int numVertices,
+        double area, double perimeter
+    );
 
     int size() const { return m_Deq.size(); }
+    int maxSize() const { return m_Deq.maxSize(); }
+
+    // Queries in O(log n), the deq is not modified (see "ConvQuery.h")
+    bool contains(const R2Point& t) const;
+    double distance(const R2Point& t) const;
+    void tangents(const R2Point& t, R2Point& left, R2Point& right) const;
+    const R2Point& extremeVertex(const R2Vector& d) const;
 
     class iterator: public R2PointDeq::iterator {
     public:
@@ -95,18 +127,62 @@ public:
     //      broken.
     bool forEach(bool (*action)(R2Point&));
 
-private:
-    // The edge [a, b> is lit from the point t
-    int lit(const R2Point& a, const R2Point& b, const R2Point& t) const {
+    // The vertices of polygon as at most two contiguous arrays
+    // (see R2PointDeq::spans)
+    int spans(R2PointSpan& first, R2PointSpan& second) const {
+        return m_Deq.spans(first, second);
+    }
+
+    // Loop for each vertex of polygon without modification of deq.
+    // The action is a function or a function object with
+    // const R2Point& parameter; the loop is broken, if it
+    // returns true. The call of action is inlined. The function
+    // object is passed by value; to keep its state after the loop,
+    // specify the reference type: forEach<Drawer&>(drawer).
+    // Return value: true, if loop was broken
+    template <class Action>
+    bool forEach(Action action) const {
+        R2PointSpan span[2];
+        int n = m_Deq.spans(span[0], span[1]);
+        for (int k = 0; k < n; ++k) {
+            const R2Point* e = span[k].end();
+            for (const R2Point* p = span[k].begin(); p != e; ++p) {
+                if (action(*p))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Orientation of the point t relative to the edge [a, b>:
+    //      1, if t lies to the left of the edge,
+    //     -1, if t lies to the right of the edge,
+    //      0, if a, b, t are collinear (up to R2GRAPH_EPSILON)
+    static int orientation(
+        const R2Point& a, const R2Point& b, const R2Point& t
+    ) {
+        double area = R2Point::signed_area(a, b, t);
+        if (area > R2GRAPH_EPSILON)
+            return 1;
+        else if (area < -R2GRAPH_EPSILON)
+            return (-1);
+        else
+            return 0;
+    }
+
+    // The edge [a, b> is lit from the point t.
+    // The test is exact: with R2GRAPH_EPSILON, a point almost
+    // collinear with an edge could light it from inside, and
+    // the area and perimeter would drift.
+    static int lit(const R2Point& a, const R2Point& b, const R2Point& t) {
         double area = R2Point::signed_area(a, b, t);
         return (
-            area > R2GRAPH_EPSILON ||
-            (
-                fabs(area) <= R2GRAPH_EPSILON && !t.between(a, b)
-            )
+            area > 0. ||
+            (area == 0. && !t.between(a, b))
         );
     }
 
+private:
     void remove(const R2Point& a, const R2Point& b, const R2Point& t);
 };
 
@@ -125,10 +201,21 @@ public:
     {
     }
 
+    // The copy does not share the polygon with the original
+    R2Convex(const R2Convex& c):
+        m_A(c.m_A),
+        m_B(c.m_B),
+        m_NumAng(c.m_NumAng),
+        m_Polygon(c.m_Polygon == 0? 0 : new R2Polygon(*c.m_Polygon))
+    {
+    }
+
     ~R2Convex() {
         delete m_Polygon;       // We can delete zero pointer
     }
 
+    R2Convex& operator=(const R2Convex& c);
+
     double area() const {
         if (m_NumAng < 3)
             return 0.;
@@ -145,7 +232,43 @@ public:
             return m_Polygon->perimeter();
     }
 
-    void addPoint(const R2Point& t);
+    // Return value: true, if the convex changed (t is outside it)
+    bool addPoint(const R2Point& t);
+
+    // Replace the convex by the convex hull of an array of points.
+    // Output-sensitive Chan's algorithm: O(n log h), where h is
+    // the number of vertices of the hull
+    void build(const R2Point* points, int numPoints);
+
+    // Replace the convex by a convex with given vertices.
+    // The vertices must be ordered clockwise and form
+    // a strictly convex polygon (a point or a line segment
+    // for 1 or 2 vertices). The storage of polygon is reused,
+    // if it is large enough
+    void assign(const R2Point* vertices, int numVertices);
+
+    // The same with known area and perimeter of the polygon
+    // (they are not computed from the vertices)
+    void assign(
+        const R2Point* vertices, int numVertices,
+        double area, double perimeter
+    );
+
+    // Operations on two convexes in O(n + m), where n, m are
+    // the numbers of vertices. The convex is replaced by the result
+    // (the storage of polygon is reused); it may be one of the
+    // arguments.
+
+    // Intersection of convexes a and b. A line segment lying on
+    // the boundary of the other convex is kept: the rounding errors
+    // are tolerated relative to the largest coordinate.
+    void intersection(const R2Convex& a, const R2Convex& b);
+
+    // Convex hull of the union of a and b
+    void unionHull(const R2Convex& a, const R2Convex& b);
+
+    // Minkowski sum {p + q: p in a, q in b}
+    void minkowskiSum(const R2Convex& a, const R2Convex& b);
 
     int size() const {
         if (m_NumAng < 3)
@@ -159,6 +282,27 @@ public:
         delete m_Polygon; m_Polygon = 0;
     }
 
+    // Queries in O(log n), where n is the number of vertices.
+    // The convex is not modified.
+
+    // Does the convex contain the point t (inside or on boundary)?
+    bool contains(const R2Point& t) const;
+
+    // Distance from the point t to the convex (zero for the points
+    // inside). Throws R2ConvexException for the empty convex.
+    double distance(const R2Point& t) const;
+
+    // Tangents from the point t: the convex lies to the right of
+    // the ray from t through the vertex left and to the left of
+    // the ray from t through the vertex right.
+    // Return value: false, if t is inside the convex (or the convex
+    // is empty), so that there are no tangents.
+    bool tangents(const R2Point& t, R2Point& left, R2Point& right) const;
+
+    // Vertex with the maximal projection to the direction d.
+    // Throws R2ConvexException for the empty convex.
+    R2Point extremeVertex(const R2Vector& d) const;
+
     class iterator {
         friend class R2Convex;
         int current;
@@ -193,7 +337,7 @@ public:
             return tmp;
         }
 
-        R2Point& operator*() throw (R2ConvexException) {
+        R2Point& operator*() {
             if (conv == 0)
                 throw R2ConvexException("Zero pointer dereference");
             if (conv->m_NumAng < 3) {
@@ -235,11 +379,11 @@ public:
             iterator(i)
         {}
 
-        const R2Point& operator*() const throw (R2ConvexException) {
+        const R2Point& operator*() const {
             return ((iterator*) this)->operator*();
         }
 
-        const R2Point* operator->() const throw (R2ConvexException) {
+        const R2Point* operator->() const {
             return &(
                 ((iterator*) this)->operator*()
             );
@@ -286,6 +430,36 @@ public:
     //      if this function returns true, then the loop will be
     //      broken.
     bool forEach(bool (*action)(R2Point&));
+
+    // The vertices of convex as at most two contiguous arrays,
+    // in the same order as for iterators. The convex is not
+    // modified; the spans are valid until the next change.
+    // Return value: the number of nonempty spans (0, 1 or 2).
+    int spans(R2PointSpan& first, R2PointSpan& second) const {
+        if (m_NumAng >= 3)
+            return m_Polygon->spans(first, second);
+        first = R2PointSpan(&m_A, (m_NumAng > 0? 1 : 0));
+        second = R2PointSpan(&m_B, (m_NumAng > 1? 1 : 0));
+        return m_NumAng;
+    }
+
+    // Loop for each vertex of convex (see R2Polygon::forEach)
+    // Return value: true, if loop was broken
+    template <class Action>
+    bool forEach(Action action) const {
+        if (m_NumAng >= 3)
+            return ((const R2Polygon*) m_Polygon)->forEach<Action>(action);
+        if (m_NumAng > 0 && action((const R2Point&) m_A))
+            return true;
+        if (m_NumAng > 1 && action((const R2Point&) m_B))
+            return true;
+        return false;
+    }
+
+private:
+    void assignHull(
+        const std::vector<R2Point>& a, const std::vector<R2Point>& b
+    );
 };
 
 #endif
@@ -0,0 +1,63 @@
+//
+// File "SnapConv.cpp"
+// Implementation of classes R2ConvexSnapshot, R2SharedConvex
+//
+#include "SnapConv.h"
+
+R2ConvexSnapshot::R2ConvexSnapshot(const R2Convex& c):
+    R2ConvexView(),
+    m_Record(convexRecordSize(c) / sizeof(double))
+{
+    serializeConvex(c, &(m_Record[0]));
+    R2ConvexView::operator=(R2ConvexView(&(m_Record[0])));
+}
+
+// End of implementation of the class R2ConvexSnapshot
+//======================================================
+
+R2SharedConvex::R2SharedConvex(bool autoPublish /* = true */):
+    m_Convex(),
+    m_Snapshot(new R2ConvexSnapshot(R2Convex())),
+    m_Lock(),
+    m_Version(0),
+    m_Changed(false),
+    m_AutoPublish(autoPublish)
+{}
+
+void R2SharedConvex::addPoint(const R2Point& t) {
+    if (m_Convex.addPoint(t))
+        changed();
+}
+
+void R2SharedConvex::build(const R2Point* points, int numPoints) {
+    m_Convex.build(points, numPoints);
+    changed();
+}
+
+void R2SharedConvex::assign(const R2Convex& c) {
+    m_Convex = c;
+    changed();
+}
+
+void R2SharedConvex::initialize() {
+    m_Convex.initialize();
+    changed();
+}
+
+void R2SharedConvex::changed() {
+    m_Changed = true;
+    if (m_AutoPublish)
+        publish();
+}
+
+void R2SharedConvex::publish() {
+    if (!m_Changed)
+        return;
+    Snapshot s(new R2ConvexSnapshot(m_Convex));
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Snapshot.swap(s);
+    }
+    m_Version.fetch_add(1, std::memory_order_release);
+    m_Changed = false;
+}
@@ -0,0 +1,118 @@
+//
+// File "SnapConv.h"
+// Interface of classes
+//      R2ConvexSnapshot - immutable copy of the vertices of a hull;
+//      R2SharedConvex   - convex hull updated by one writer thread
+//                         and read concurrently by other threads
+//                         through snapshots.
+// Used classes:
+//      R2Convex, R2ConvexView, R2Point
+
+#ifndef SNAP_CONV_H
+#   define SNAP_CONV_H
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include "R2Graph/R2Graph.h"
+#include "R2Conv.h"
+#include "ConvFile.h"
+
+//
+// The vertices, area and perimeter of a hull in a record of
+// the size of the hull (see "ConvFile.h"), with the queries
+// of R2ConvexView.
+//
+class R2ConvexSnapshot: public R2ConvexView {
+    std::vector<double> m_Record;
+
+public:
+    R2ConvexSnapshot(const R2Convex& c);
+
+private:
+    R2ConvexSnapshot(const R2ConvexSnapshot&);              // Not implemented
+    R2ConvexSnapshot& operator=(const R2ConvexSnapshot&);   // Not implemented
+};
+
+//
+// The writer changes its own copy of convex; after a change
+// its vertices are published as a new snapshot (copy on write).
+// A snapshot is never modified: a reader gets a pointer to
+// the current one in O(1) and may use it as long as it likes,
+// while the writer goes on. A snapshot is deleted, when the
+// last reader releases it.
+// The pointer to the current snapshot is guarded by a lock
+// of the object: a reader holds it only to copy the pointer,
+// the writer only to replace it (the snapshot is made and
+// the old one is deleted outside of the lock).
+// The methods of writer must be called from one thread at a time;
+// snapshot() and version() may be called from any thread.
+//
+class R2SharedConvex {
+public:
+    typedef std::shared_ptr<const R2ConvexSnapshot> Snapshot;
+
+private:
+    R2Convex            m_Convex;       // Working copy of the writer
+    Snapshot            m_Snapshot;     // Guarded by m_Lock
+    mutable std::mutex  m_Lock;
+    std::atomic<long>   m_Version;      // Number of publications
+    bool                m_Changed;      // Not published yet
+    bool                m_AutoPublish;
+
+public:
+    // With autoPublish, every change of the hull is published
+    // at once; otherwise, the changes are published by publish()
+    // (e.g. once per frame, when many points are added)
+    R2SharedConvex(bool autoPublish = true);
+
+    ~R2SharedConvex() {}
+
+    // Methods of writer
+
+    // Add the point t; the snapshot is made only if the hull
+    // changes (a point inside the hull costs nothing more)
+    void addPoint(const R2Point& t);
+
+    // Replace the hull (see R2Convex::build, R2Convex::assign)
+    void build(const R2Point* points, int numPoints);
+    void assign(const R2Convex& c);
+
+    void initialize();
+
+    // Publish the current hull, if it was changed after
+    // the last publication
+    void publish();
+
+    bool autoPublish() const { return m_AutoPublish; }
+    void setAutoPublish(bool a) { m_AutoPublish = a; }
+
+    // The working copy (for the writer thread only)
+    const R2Convex& convex() const { return m_Convex; }
+
+    // Methods of readers
+
+    // The last published hull
+    Snapshot snapshot() const {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Snapshot;
+    }
+
+    // Number of publications: a reader may compare it with the
+    // value it has seen before, to find out whether it should
+    // take a new snapshot
+    long version() const {
+        return m_Version.load(std::memory_order_acquire);
+    }
+
+private:
+    R2SharedConvex(const R2SharedConvex&);              // Not implemented
+    R2SharedConvex& operator=(const R2SharedConvex&);   // Not implemented
+
+    void changed();
+};
+
+#endif
+//
+// End of file "SnapConv.h"
@@ -0,0 +1,36 @@
+//
+// File "WinConv.cpp"
+// Implementation of class R2WindowConvex
+//
+#include "WinConv.h"
+
+void R2WindowConvex::addPoint(const R2Point& t, double time /* = 0. */) {
+    m_Window.push_back(Item(t, time));
+    m_Convex.addPoint(t);
+    if (m_MaxPoints > 0) {
+        while ((int) m_Window.size() > m_MaxPoints)
+            removeOldest();
+    }
+    if (m_MaxAge > 0.)
+        expire(time);
+}
+
+int R2WindowConvex::expire(double now) {
+    int n = 0;
+    if (m_MaxAge <= 0.)
+        return 0;
+    double limit = now - m_MaxAge;
+    while (!m_Window.empty() && m_Window.front().time < limit) {
+        removeOldest();
+        ++n;
+    }
+    return n;
+}
+
+bool R2WindowConvex::removeOldest() {
+    if (m_Window.empty())
+        return false;
+    m_Convex.removePoint(m_Window.front().point);
+    m_Window.pop_front();
+    return true;
+}
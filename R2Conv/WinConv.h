@@ -0,0 +1,107 @@
+//
+// File "WinConv.h"
+// Interface of class R2WindowConvex:
+//      convex hull of a sliding window of a point stream,
+//      i.e. of the last N points or of the points not older
+//      than T seconds.
+// Used classes:
+//      R2Point, R2DynamicConvex
+
+#ifndef WIN_CONV_H
+#   define WIN_CONV_H
+
+#include <deque>
+#include "R2Graph/R2Graph.h"
+#include "DynConv.h"
+
+//
+// The points of window are kept in a queue in order of arrival
+// and in a dynamic hull, so that both push of a new point and
+// expiration of the oldest one cost O(log^2 n).
+//
+class R2WindowConvex {
+public:
+    class Item {
+    public:
+        R2Point point;
+        double  time;
+
+        Item(const R2Point& p, double t):
+            point(p),
+            time(t)
+        {}
+    };
+
+    typedef R2DynamicConvex::const_iterator const_iterator;
+
+private:
+    R2DynamicConvex     m_Convex;
+    std::deque<Item>    m_Window;
+    int                 m_MaxPoints;    // 0 means no limit
+    double              m_MaxAge;       // 0 means no limit
+
+public:
+    // The window is limited by the number of points maxPoints
+    // and/or by the age of points maxAge (the zero value means
+    // no limit)
+    R2WindowConvex(int maxPoints = 0, double maxAge = 0.):
+        m_Convex(),
+        m_Window(),
+        m_MaxPoints(maxPoints),
+        m_MaxAge(maxAge)
+    {}
+
+    ~R2WindowConvex() {}
+
+    // Add the point t arrived at the moment time, and expire
+    // the points that are out of window. The time should not
+    // decrease from call to call.
+    void addPoint(const R2Point& t, double time = 0.);
+
+    // Expire the points older than now - maxAge
+    // Return value: the number of expired points
+    int expire(double now);
+
+    // Remove the oldest point of window
+    // Return value: false, if the window is empty
+    bool removeOldest();
+
+    void initialize() {
+        m_Convex.initialize();
+        m_Window.clear();
+    }
+
+    int maxPoints() const { return m_MaxPoints; }
+    double maxAge() const { return m_MaxAge; }
+
+    // Number of points in the window
+    int numPoints() const { return (int) m_Window.size(); }
+    bool empty() const { return m_Window.empty(); }
+
+    const Item& oldest() const { return m_Window.front(); }
+    const Item& newest() const { return m_Window.back(); }
+
+    // Number of vertices of the hull
+    int size() const { return m_Convex.size(); }
+
+    double area() const { return m_Convex.area(); }
+    double perimeter() const { return m_Convex.perimeter(); }
+
+    // Vertices of the hull, clockwise from the leftmost one
+    const_iterator begin() const { return m_Convex.begin(); }
+    const_iterator end() const { return m_Convex.end(); }
+
+    bool forEach(bool (*action)(const R2Point&)) const {
+        return m_Convex.forEach(action);
+    }
+
+    const R2DynamicConvex& convex() const { return m_Convex; }
+
+private:
+    R2WindowConvex(const R2WindowConvex&);              // Not implemented
+    R2WindowConvex& operator=(const R2WindowConvex&);   // Not implemented
+};
+
+#endif
+//
+// End of file "WinConv.h"
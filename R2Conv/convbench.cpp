@@ -0,0 +1,244 @@
+//
+// File "convbench.cpp"
+// Benchmark of convex hull construction.
+// Usage:
+//      convbench [maxSize [timeBudget [distribution [method]]]]
+// The sizes of input are 10^3, 10^4, ..., maxSize (10^7 by default,
+// at most 10^8). A method is not run on the larger sizes, when its
+// time would exceed timeBudget seconds (10 by default), judging
+// by the previous size. Distributions: square, disk, circle,
+// gauss, line, or all; methods: addPoint, build, dynamic, approx,
+// or all.
+// For every run, the time, the number of points per second and
+// the peak resident memory of the process so far are printed.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <vector>
+#include "R2Graph/R2Graph.h"
+#include "R2Conv.h"
+#include "DynConv.h"
+#include "ApproxConv.h"
+
+//
+// Generator of random points
+//
+class PointGenerator {
+public:
+    enum Distribution {
+        SQUARE,     // Uniform in the unit square
+        DISK,       // Uniform in the unit disk
+        CIRCLE,     // On the unit circle: all points are on the hull
+        GAUSS,      // Normal distribution
+        LINE,       // Near-collinear: a line with noise 1e-9
+        NUM_DISTRIBUTIONS
+    };
+
+private:
+    Distribution        m_Distribution;
+    unsigned long long  m_State;
+
+public:
+    PointGenerator(Distribution d, unsigned long long seed = 1):
+        m_Distribution(d),
+        m_State(seed * 0x9E3779B97F4A7C15ULL + 1)
+    {}
+
+    static const char* name(Distribution d) {
+        static const char* names[NUM_DISTRIBUTIONS] = {
+            "square", "disk", "circle", "gauss", "line"
+        };
+        return names[d];
+    }
+
+    // Uniform in [0, 1) (xorshift64*)
+    double uniform() {
+        m_State ^= m_State >> 12;
+        m_State ^= m_State << 25;
+        m_State ^= m_State >> 27;
+        unsigned long long r = m_State * 2685821657736338717ULL;
+        return (double)(r >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    R2Point next() {
+        switch (m_Distribution) {
+        case SQUARE:
+            return R2Point(uniform(), uniform());
+        case DISK: {
+            double r = sqrt(uniform());
+            double phi = 2. * M_PI * uniform();
+            return R2Point(r * cos(phi), r * sin(phi));
+        }
+        case CIRCLE: {
+            double phi = 2. * M_PI * uniform();
+            return R2Point(cos(phi), sin(phi));
+        }
+        case GAUSS: {
+            // Box-Muller transform
+            double r = sqrt(-2. * log(1. - uniform()));
+            double phi = 2. * M_PI * uniform();
+            return R2Point(r * cos(phi), r * sin(phi));
+        }
+        default: {
+            double t = uniform();
+            return R2Point(t, 0.5 * t + 1e-9 * (uniform() - 0.5));
+        }
+        }
+    }
+};
+
+enum Method {
+    ADD_POINT,      // R2Convex::addPoint
+    BUILD,          // R2Convex::build
+    DYNAMIC,        // R2DynamicConvex::addPoint
+    APPROX,         // R2ApproxConvex, 256 directions
+    NUM_METHODS
+};
+
+static const char* methodNames[NUM_METHODS] = {
+    "addPoint", "build", "dynamic", "approx"
+};
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+// Peak resident set size of the process, in megabytes
+static double peakMemory() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) usage.ru_maxrss / 1024.;    // ru_maxrss is in KB
+}
+
+// Run the method on n points.
+// Return value: false, if the method failed.
+static bool run(
+    Method method, PointGenerator::Distribution d, int n,
+    double& seconds, int& hullSize, double& area
+) {
+    PointGenerator gen(d);
+    std::vector<R2Point> points;
+    if (method == BUILD) {
+        // The points are generated before the timing
+        points.resize(n);
+        for (int i = 0; i < n; ++i)
+            points[i] = gen.next();
+    }
+
+    double start = now();
+    try {
+        if (method == ADD_POINT) {
+            R2Convex conv;
+            for (int i = 0; i < n; ++i)
+                conv.addPoint(gen.next());
+            hullSize = conv.size(); area = conv.area();
+        } else if (method == BUILD) {
+            R2Convex conv;
+            conv.build(&(points[0]), n);
+            hullSize = conv.size(); area = conv.area();
+        } else if (method == DYNAMIC) {
+            R2DynamicConvex conv;
+            for (int i = 0; i < n; ++i)
+                conv.addPoint(gen.next());
+            hullSize = conv.size(); area = conv.area();
+        } else {
+            R2ApproxConvex approx(256);
+            for (int i = 0; i < n; ++i)
+                approx.addPoint(gen.next());
+            R2Convex conv;
+            approx.toConvex(conv);
+            hullSize = conv.size(); area = conv.area();
+        }
+    } catch (DeqException& e) {
+        printf("%-9s %-7s %10d  failed: %s\n",
+            methodNames[method], PointGenerator::name(d), n, e.reason);
+        return false;
+    } catch (R2ConvexException& e) {
+        printf("%-9s %-7s %10d  failed: %s\n",
+            methodNames[method], PointGenerator::name(d), n, e.reason);
+        return false;
+    }
+    seconds = now() - start;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    double maxSize = 1e7;
+    double budget = 10.;
+    int firstDistribution = 0, lastDistribution = PointGenerator::NUM_DISTRIBUTIONS - 1;
+    int firstMethod = 0, lastMethod = NUM_METHODS - 1;
+
+    if (argc > 1)
+        maxSize = atof(argv[1]);
+    if (argc > 2)
+        budget = atof(argv[2]);
+    if (argc > 3 && strcmp(argv[3], "all") != 0) {
+        int d;
+        for (d = 0; d < PointGenerator::NUM_DISTRIBUTIONS; ++d) {
+            if (strcmp(argv[3], PointGenerator::name(
+                (PointGenerator::Distribution) d)) == 0)
+                break;
+        }
+        if (d >= PointGenerator::NUM_DISTRIBUTIONS) {
+            fprintf(stderr, "Unknown distribution %s\n", argv[3]);
+            return 1;
+        }
+        firstDistribution = lastDistribution = d;
+    }
+    if (argc > 4 && strcmp(argv[4], "all") != 0) {
+        int m;
+        for (m = 0; m < NUM_METHODS; ++m) {
+            if (strcmp(argv[4], methodNames[m]) == 0)
+                break;
+        }
+        if (m >= NUM_METHODS) {
+            fprintf(stderr, "Unknown method %s\n", argv[4]);
+            return 1;
+        }
+        firstMethod = lastMethod = m;
+    }
+    if (maxSize > 1e8)
+        maxSize = 1e8;
+
+    printf("%-9s %-7s %10s %10s %12s %8s %14s %9s\n",
+        "method", "input", "n", "seconds", "points/s", "hull",
+        "area", "peak MB");
+    for (int m = firstMethod; m <= lastMethod; ++m) {
+        for (int d = firstDistribution; d <= lastDistribution; ++d) {
+            double lastTime = 0.;
+            for (double size = 1e3; size <= maxSize; size *= 10.) {
+                int n = (int) size;
+                // The time grows at least linearly
+                if (lastTime * 10. > budget) {
+                    printf("%-9s %-7s %10d  skipped (time budget)\n",
+                        methodNames[m],
+                        PointGenerator::name((PointGenerator::Distribution) d),
+                        n);
+                    break;
+                }
+                double seconds = 0., area = 0.;
+                int hullSize = 0;
+                if (!run(
+                    (Method) m, (PointGenerator::Distribution) d, n,
+                    seconds, hullSize, area
+                ))
+                    break;
+                printf("%-9s %-7s %10d %10.4f %12.4g %8d %14.10g %9.1f\n",
+                    methodNames[m],
+                    PointGenerator::name((PointGenerator::Distribution) d),
+                    n, seconds, (seconds > 0.? n / seconds : 0.),
+                    hullSize, area, peakMemory());
+                fflush(stdout);
+                lastTime = seconds;
+            }
+        }
+    }
+    return 0;
+}
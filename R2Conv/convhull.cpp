@@ -0,0 +1,372 @@
+//
+// File "convhull.cpp"
+// Command-line tool: convex hull of points from a file.
+// Usage:
+//      convhull [-a algorithm] [-k directions] [-c chunkSize]
+//               [-f text|binary] [-q] [file]
+// Algorithms:
+//      build   - R2Convex::build, by chunks (default)
+//      add     - R2Convex::addPoint
+//      approx  - R2ApproxConvex with k directions (256 by default)
+// The text file contains the coordinates x y of points separated
+// by spaces, commas or line ends; the text after '#' up to the end
+// of line is ignored. The binary file (the default for the names
+// ending with ".bin") is an array of pairs of doubles x, y in the
+// native byte order; it is mapped to memory. Without file name,
+// the text is read from the standard input.
+// The output contains the vertices of hull (clockwise, one per
+// line; omitted with -q), area and perimeter.
+// The memory used is bounded by the chunk size (10^6 points by
+// default) and the size of hull, whatever the size of input.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <charconv>
+#include <vector>
+#include "R2Graph/R2Graph.h"
+#include "R2Conv.h"
+#include "ApproxConv.h"
+
+//
+// Sources of points
+//
+class PointSource {
+public:
+    virtual ~PointSource() {}
+
+    // Read at most maxCount points to the array.
+    // Return value: the number of points read, 0 at the end of input.
+    virtual int read(R2Point* points, int maxCount) = 0;
+};
+
+// Text file, parsed by blocks
+class TextPointSource: public PointSource {
+    FILE*               m_File;
+    std::vector<char>   m_Buffer;
+    int                 m_Begin;    // Unparsed part of buffer
+    int                 m_End;
+    bool                m_Eof;
+    bool                m_InComment; // After "#" up to the end of line
+    bool                m_HaveX;    // x is read, y is expected
+    double              m_X;
+    long                m_Line;
+
+public:
+    TextPointSource(FILE* f):
+        m_File(f),
+        m_Buffer(1 << 20),
+        m_Begin(0),
+        m_End(0),
+        m_Eof(false),
+        m_InComment(false),
+        m_HaveX(false),
+        m_X(0.),
+        m_Line(1)
+    {}
+
+    virtual int read(R2Point* points, int maxCount);
+
+private:
+    bool fill();
+    static bool isSeparator(char c) {
+        return (c == ' ' || c == '\t' || c == ',' || c == '\r' || c == ';');
+    }
+};
+
+// Move the unparsed tail to the beginning of buffer and read
+// the next block.
+// Return value: false, if nothing was read.
+bool TextPointSource::fill() {
+    int len = m_End - m_Begin;
+    memmove(&(m_Buffer[0]), &(m_Buffer[m_Begin]), len);
+    m_Begin = 0;
+    m_End = len;
+    if (m_Eof)
+        return false;
+    if (m_End == (int) m_Buffer.size())
+        m_Buffer.resize(2 * m_Buffer.size());   // A very long token
+    size_t n = fread(&(m_Buffer[m_End]), 1, m_Buffer.size() - m_End, m_File);
+    if (n == 0)
+        m_Eof = true;
+    m_End += (int) n;
+    return (n > 0);
+}
+
+int TextPointSource::read(R2Point* points, int maxCount) {
+    int count = 0;
+    while (count < maxCount) {
+        // Skip the separators and comments
+        while (true) {
+            while (m_Begin < m_End) {
+                char c = m_Buffer[m_Begin];
+                if (c == '\n') {
+                    ++m_Line; ++m_Begin;
+                    m_InComment = false;
+                } else if (m_InComment) {
+                    const char* eol = (const char*) memchr(
+                        &(m_Buffer[m_Begin]), '\n', m_End - m_Begin
+                    );
+                    m_Begin = (eol != 0? (int)(eol - &(m_Buffer[0])) : m_End);
+                } else if (isSeparator(c)) {
+                    ++m_Begin;
+                } else if (c == '#') {
+                    m_InComment = true;     // Up to the end of line,
+                    ++m_Begin;              // maybe after fill()
+                } else {
+                    break;
+                }
+            }
+            if (m_Begin < m_End)
+                break;
+            if (!fill() && m_Begin >= m_End) {
+                if (m_HaveX) {
+                    fprintf(stderr, "Line %ld: y coordinate missing\n", m_Line);
+                    exit(1);
+                }
+                return count;
+            }
+        }
+
+        // The token must be complete: it ends before the end of buffer
+        int e = m_Begin;
+        while (
+            e < m_End && !isSeparator(m_Buffer[e]) &&
+            m_Buffer[e] != '\n' && m_Buffer[e] != '#'
+        )
+            ++e;
+        if (e >= m_End && !m_Eof) {
+            fill();
+            continue;
+        }
+
+        double value;
+        const char* first = &(m_Buffer[0]) + m_Begin;
+        const char* last = &(m_Buffer[0]) + e;
+        if (*first == '+')
+            ++first;            // from_chars does not accept '+'
+        std::from_chars_result res = std::from_chars(first, last, value);
+        if (res.ec != std::errc() || res.ptr != last) {
+            fprintf(
+                stderr, "Line %ld: bad number \"%.*s\"\n",
+                m_Line, (int)(e - m_Begin), &(m_Buffer[m_Begin])
+            );
+            exit(1);
+        }
+        m_Begin = e;
+        if (m_HaveX) {
+            points[count++] = R2Point(m_X, value);
+            m_HaveX = false;
+        } else {
+            m_X = value;
+            m_HaveX = true;
+        }
+    }
+    return count;
+}
+
+// Binary file mapped to memory
+class BinaryPointSource: public PointSource {
+    const double*   m_Data;
+    size_t          m_Size;         // In bytes
+    size_t          m_NumPoints;
+    size_t          m_Current;
+
+public:
+    BinaryPointSource(const char* path);
+    virtual ~BinaryPointSource();
+
+    virtual int read(R2Point* points, int maxCount);
+};
+
+BinaryPointSource::BinaryPointSource(const char* path):
+    m_Data(0),
+    m_Size(0),
+    m_NumPoints(0),
+    m_Current(0)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        exit(1);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(path);
+        exit(1);
+    }
+    m_Size = (size_t) st.st_size;
+    if (m_Size % (2 * sizeof(double)) != 0) {
+        fprintf(stderr, "%s: size is not a multiple of 16 bytes\n", path);
+        exit(1);
+    }
+    m_NumPoints = m_Size / (2 * sizeof(double));
+    if (m_Size > 0) {
+        void* p = mmap(0, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            perror(path);
+            exit(1);
+        }
+        madvise(p, m_Size, MADV_SEQUENTIAL);
+        m_Data = (const double*) p;
+    }
+    close(fd);
+}
+
+BinaryPointSource::~BinaryPointSource() {
+    if (m_Data != 0)
+        munmap((void*) m_Data, m_Size);
+}
+
+int BinaryPointSource::read(R2Point* points, int maxCount) {
+    size_t n = m_NumPoints - m_Current;
+    if (n > (size_t) maxCount)
+        n = (size_t) maxCount;
+    const double* d = m_Data + 2 * m_Current;
+    for (size_t i = 0; i < n; ++i)
+        points[i] = R2Point(d[2*i], d[2*i + 1]);
+    m_Current += n;
+    if (m_Data != 0 && m_Current < m_NumPoints) {
+        // The pages already read are not needed any more
+        size_t page = (size_t) sysconf(_SC_PAGESIZE);
+        size_t done = (2 * m_Current * sizeof(double)) / page * page;
+        if (done > 0)
+            madvise((void*) m_Data, done, MADV_DONTNEED);
+    }
+    return (int) n;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: convhull [-a build|add|approx] [-k directions]\n"
+        "                [-c chunkSize] [-f text|binary] [-q] [file]\n"
+    );
+    exit(1);
+}
+
+static void printResult(
+    const std::vector<R2Point>& vertices, double area, double perimeter,
+    bool quiet
+) {
+    if (!quiet) {
+        printf("# %d vertices\n", (int) vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+            printf("%.17g %.17g\n", vertices[i].x, vertices[i].y);
+    }
+    printf("# area %.17g\n", area);
+    printf("# perimeter %.17g\n", perimeter);
+}
+
+static void convexVertices(const R2Convex& conv, std::vector<R2Point>& v) {
+    v.clear();
+    R2PointSpan span[2];
+    int n = conv.spans(span[0], span[1]);
+    for (int k = 0; k < n; ++k)
+        v.insert(v.end(), span[k].begin(), span[k].end());
+}
+
+int main(int argc, char* argv[]) {
+    const char* algorithm = "build";
+    const char* format = 0;
+    const char* path = 0;
+    int directions = 256;
+    int chunkSize = 1000000;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i+1 < argc)
+            algorithm = argv[++i];
+        else if (strcmp(argv[i], "-k") == 0 && i+1 < argc)
+            directions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+            chunkSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i+1 < argc)
+            format = argv[++i];
+        else if (strcmp(argv[i], "-q") == 0)
+            quiet = true;
+        else if (argv[i][0] == '-' && argv[i][1] != 0)
+            usage();
+        else if (path == 0)
+            path = argv[i];
+        else
+            usage();
+    }
+    if (chunkSize < 1 || directions < 4)
+        usage();
+    if (format == 0) {
+        size_t len = (path == 0? 0 : strlen(path));
+        format = (len > 4 && strcmp(path + len - 4, ".bin") == 0?
+            "binary" : "text");
+    }
+
+    PointSource* source = 0;
+    FILE* file = 0;
+    if (strcmp(format, "binary") == 0) {
+        if (path == 0) {
+            fprintf(stderr, "Binary input must be a file\n");
+            return 1;
+        }
+        source = new BinaryPointSource(path);
+    } else if (strcmp(format, "text") == 0) {
+        file = (path == 0? stdin : fopen(path, "r"));
+        if (file == 0) {
+            perror(path);
+            return 1;
+        }
+        source = new TextPointSource(file);
+    } else {
+        usage();
+    }
+
+    std::vector<R2Point> chunk(chunkSize);
+    std::vector<R2Point> vertices;
+    int n;
+    try {
+        if (strcmp(algorithm, "build") == 0) {
+            // The hull of a chunk together with the hull
+            // of previous chunks
+            R2Convex conv;
+            while ((n = source->read(&(chunk[0]), chunkSize)) > 0) {
+                chunk.resize(n);
+                chunk.insert(chunk.end(), vertices.begin(), vertices.end());
+                conv.build(&(chunk[0]), (int) chunk.size());
+                convexVertices(conv, vertices);
+                chunk.resize(chunkSize);
+            }
+            printResult(vertices, conv.area(), conv.perimeter(), quiet);
+        } else if (strcmp(algorithm, "add") == 0) {
+            R2Convex conv;
+            while ((n = source->read(&(chunk[0]), chunkSize)) > 0) {
+                for (int i = 0; i < n; ++i)
+                    conv.addPoint(chunk[i]);
+            }
+            convexVertices(conv, vertices);
+            printResult(vertices, conv.area(), conv.perimeter(), quiet);
+        } else if (strcmp(algorithm, "approx") == 0) {
+            R2ApproxConvex approx(directions);
+            while ((n = source->read(&(chunk[0]), chunkSize)) > 0)
+                approx.addPoints(&(chunk[0]), n);
+            R2Convex conv;
+            approx.toConvex(conv);
+            convexVertices(conv, vertices);
+            printResult(vertices, conv.area(), conv.perimeter(), quiet);
+        } else {
+            usage();
+        }
+    } catch (DeqException& e) {
+        fprintf(stderr, "Deq exception: %s\n", e.reason);
+        return 1;
+    } catch (R2ConvexException& e) {
+        fprintf(stderr, "Convex exception: %s\n", e.reason);
+        return 1;
+    }
+
+    delete source;
+    if (file != 0 && file != stdin)
+        fclose(file);
+    return 0;
+}
@@ -13,6 +13,32 @@ class MyWindow: public GWindow {
     virtual void onButtonPress(XEvent& event);
 };
 
+// Draws the edges between the successive vertices of convex
+class EdgeDrawer {
+public:
+    GWindow*    window;
+    R2Point     first;
+    R2Point     last;
+    bool        started;
+
+    EdgeDrawer(GWindow* w):
+        window(w),
+        first(),
+        last(),
+        started(false)
+    {}
+
+    bool operator()(const R2Point& v) {
+        if (started)
+            window->drawLine(last, v);
+        else
+            first = v;
+        last = v;
+        started = true;
+        return false;
+    }
+};
+
 //----------------------------------------------------------
 // Implementation of class "MyWindow"
 //
@@ -28,24 +54,12 @@ void MyWindow::onExpose(XEvent& /* event */) { // Draw a window
     int n = conv.size();
     if (n > 0) {
         setForeground("blue");
-        R2Convex::const_iterator b, e, i, j;
-        b = conv.begin();       // Pointer to beginning
-        e = conv.end();         // Pointer to after-end
-        i = b;                  // Pointer to current vertex
-        j = b;                  // Pointer to the next vertex
-        ++j;
-
-        while (i != e) {
-            R2Point v0 = *i;    // Edge beginning
-            R2Point v1;         // Edge end
-            if (j != e)
-                v1 = *j;
-            else
-                v1 = *b;        // Close the polygon
-
-            drawLine(v0, v1);   // Draw current edge
-            i = j; ++j;         // Go to the next edge
-        }
+        EdgeDrawer drawer(this);
+        conv.forEach<EdgeDrawer&>(drawer); // All edges but the last one
+        if (n > 1)
+            drawLine(drawer.last, drawer.first);    // Close the polygon
+        else
+            drawLine(drawer.first, drawer.first);
 
         // Draw convex perimeter and area
         setForeground("brown");
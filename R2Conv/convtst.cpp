@@ -1,6 +1,8 @@
-#include <iostream.h>
+#include <iostream>
 #include "R2Conv.h"
 
+using namespace std;
+
 int main() {
     R2Point p;
     int i, n;
@@ -0,0 +1,130 @@
+//
+// Test of the binary storage of convex hulls
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <vector>
+#include "ConvFile.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name) {
+    printf("%-50s %s\n", name, ok? "ok" : "FAILED");
+    if (!ok)
+        ++failures;
+}
+
+// Hull number k of the file: from 0 to 50 vertices of different
+// sizes, at different places
+static void hull(int k, R2Convex& c) {
+    R2Point points[50];
+    int n = k % 51;
+    for (int i = 0; i < n; ++i) {
+        double phi = 2. * M_PI * i / n;
+        points[i] = R2Point(k + (k+1) * cos(phi), -k + sin(phi));
+    }
+    c.build(points, n);
+}
+
+// The view has the same hull and answers the same queries
+static bool sameHull(const R2ConvexView& v, const R2Convex& c) {
+    if (
+        v.size() != c.size() || v.area() != c.area() ||
+        v.perimeter() != c.perimeter()
+    )
+        return false;
+    R2Convex copy;
+    v.toConvex(copy);
+    if (copy.size() != c.size() || copy.area() != c.area())
+        return false;
+    if (c.size() == 0)
+        return true;
+    R2Point t(3., 4.);
+    R2Vector d(1., 2.);
+    return (
+        v.contains(t) == c.contains(t) &&
+        v.distance(t) == c.distance(t) &&
+        v.extremeVertex(d) == c.extremeVertex(d)
+    );
+}
+
+static void testRecord() {
+    R2Convex c;
+    hull(20, c);
+    std::vector<double> buffer(convexRecordSize(c) / sizeof(double));
+    size_t size = serializeConvex(c, &(buffer[0]));
+    check(
+        size == convexRecordSize(c) && sameHull(R2ConvexView(&(buffer[0])), c),
+        "file: record in memory"
+    );
+}
+
+// Change the length of the file by delta
+static void truncateFile(const char* path, long delta) {
+    FILE* f = fopen(path, "rb");
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fclose(f);
+    if (truncate(path, length + delta) != 0)
+        perror(path);
+}
+
+// Replace the byte of the file at the offset by c
+static void patchFile(const char* path, long offset, char c) {
+    FILE* f = fopen(path, "r+b");
+    fseek(f, offset, SEEK_SET);
+    fputc(c, f);
+    fclose(f);
+}
+
+static void testFile() {
+    const int NUM_HULLS = 200;
+    char path[] = "/tmp/filetstXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        check(false, "file: temporary file");
+        return;
+    }
+    close(fd);
+
+    R2ConvexWriter w;
+    bool ok = w.open(path);
+    for (int k = 0; ok && k < NUM_HULLS; ++k) {
+        R2Convex c;
+        hull(k, c);
+        w.add(c);
+    }
+    ok = ok && w.size() == NUM_HULLS && w.close();
+    check(ok, "file: write");
+
+    R2ConvexFile f;
+    ok = f.open(path) && f.size() == NUM_HULLS;
+    for (int k = 0; ok && k < NUM_HULLS; ++k) {
+        R2Convex c;
+        hull(k, c);
+        ok = sameHull(f[k], c);
+    }
+    f.close();
+    check(ok, "file: read");
+
+    truncateFile(path, -8);
+    R2ConvexFile truncated;
+    bool truncatedOk = truncated.open(path);
+    patchFile(path, 0, 'X');
+    R2ConvexFile corrupted;
+    check(
+        !truncatedOk && !corrupted.open(path) &&
+            !corrupted.open("/nonexistent/hulls"),
+        "file: wrong files are rejected"
+    );
+    unlink(path);
+}
+
+int main() {
+    testRecord();
+    testFile();
+    printf("%d failed\n", failures);
+    return (failures != 0);
+}
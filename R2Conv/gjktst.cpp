@@ -0,0 +1,140 @@
+//
+// Test of the distance, overlap and penetration of convexes
+//
+#include <stdio.h>
+#include <math.h>
+#include "ConvGjk.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name) {
+    printf("%-50s %s\n", name, ok? "ok" : "FAILED");
+    if (!ok)
+        ++failures;
+}
+
+// Rectangle [x0, x1]*[y0, y1] (the vertices go clockwise)
+static void rectangle(
+    R2Convex& c, double x0, double y0, double x1, double y1
+) {
+    R2Point v[4] = {
+        R2Point(x0, y0), R2Point(x0, y1), R2Point(x1, y1), R2Point(x1, y0)
+    };
+    c.assign(v, 4);
+}
+
+static void testRectangles() {
+    R2Convex a, b;
+    R2Point pa, pb;
+    rectangle(a, 0., 0., 1., 1.);
+    rectangle(b, 3., 0.5, 4., 2.);
+    double d = gjkDistance(a, b, pa, pb);
+    check(
+        fabs(d - 2.) <= 1e-12 && fabs(pa.x - 1.) <= 1e-12 &&
+            fabs(pb.x - 3.) <= 1e-12 && fabs(pa.y - pb.y) <= 1e-12,
+        "gjk: distance of rectangles"
+    );
+    check(
+        !gjkOverlap(a, b) && gjkWithin(a, b, 2.5) && !gjkWithin(a, b, 1.5),
+        "gjk: overlap and within"
+    );
+
+    R2Convex p;
+    p.addPoint(R2Point(3., 3.));
+    check(
+        fabs(gjkDistance(a, p, pa, pb) - sqrt(8.)) <= 1e-12,
+        "gjk: distance to a point"
+    );
+
+    rectangle(b, 0.5, 0.75, 3., 3.);
+    R2Vector normal;
+    double depth;
+    bool penetrates = epaPenetration(a, b, normal, depth);
+    check(
+        gjkOverlap(a, b) && gjkDistance(a, b, pa, pb) == 0. &&
+            penetrates && fabs(depth - 0.25) <= 1e-12 &&
+            fabs(normal.x) <= 1e-12 && fabs(normal.y - 1.) <= 1e-12,
+        "gjk: penetration of rectangles"
+    );
+
+    rectangle(b, 1., 0., 2., 1.);
+    check(gjkOverlap(a, b), "gjk: touching rectangles overlap");
+
+    R2Convex empty;
+    bool thrown = false;
+    try {
+        gjkDistance(a, empty, pa, pb);
+    } catch (R2ConvexException&) {
+        thrown = true;
+    }
+    check(thrown, "gjk: empty convex");
+}
+
+// Uniform in [0, 1) (xorshift64*, as in convbench)
+static double uniform(unsigned long long& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    unsigned long long r = state * 2685821657736338717ULL;
+    return (double)(r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Hull of 20 points in the unit disk around a random center
+static void randomConvex(R2Convex& c, unsigned long long& state) {
+    double cx = 4. * uniform(state), cy = 4. * uniform(state);
+    R2Point points[20];
+    for (int i = 0; i < 20; ++i) {
+        double r = sqrt(uniform(state));
+        double phi = 2. * M_PI * uniform(state);
+        points[i] = R2Point(cx + r * cos(phi), cy + r * sin(phi));
+    }
+    c.build(points, 20);
+}
+
+// The distance of disjoint convexes is the least distance from
+// a vertex of one convex to the other convex
+static double vertexDistance(const R2Convex& a, const R2Convex& b) {
+    double d = HUGE_VAL;
+    R2Convex::const_iterator i;
+    for (i = a.begin(); i != a.end(); ++i)
+        d = fmin(d, b.distance(*i));
+    for (i = b.begin(); i != b.end(); ++i)
+        d = fmin(d, a.distance(*i));
+    return d;
+}
+
+// GJK against the intersection of convexes and the distances
+// to vertices; the warm start gives the same answers
+static void testRandom() {
+    unsigned long long state = 7;
+    int errors = 0, overlaps = 0;
+    R2GjkSimplex simplex;
+    for (int k = 0; k < 1000; ++k) {
+        R2Convex a, b, c;
+        randomConvex(a, state);
+        randomConvex(b, state);
+        c.intersection(a, b);
+        R2Point pa, pb;
+        double d = gjkDistance(a, b, pa, pb);
+        bool overlap = gjkOverlap(a, b);
+        if (overlap != (c.size() > 0) || overlap != (d == 0.))
+            ++errors;
+        if (!overlap && fabs(d - vertexDistance(a, b)) > 1e-9)
+            ++errors;
+        if (gjkOverlap(a, b, &simplex) != overlap)
+            ++errors;
+        if (overlap)
+            ++overlaps;
+    }
+    check(
+        errors == 0 && overlaps > 0 && overlaps < 1000,
+        "gjk: random convexes"
+    );
+}
+
+int main() {
+    testRectangles();
+    testRandom();
+    printf("%d failed\n", failures);
+    return (failures != 0);
+}
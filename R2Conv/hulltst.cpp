@@ -0,0 +1,145 @@
+//
+// Test of operations on convexes
+//
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "R2Conv.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name) {
+    printf("%-50s %s\n", name, ok? "ok" : "FAILED");
+    if (!ok)
+        ++failures;
+}
+
+// Rectangle [x0, x1]*[y0, y1] (the vertices go clockwise)
+static void rectangle(
+    R2Convex& c, double x0, double y0, double x1, double y1
+) {
+    R2Point v[4] = {
+        R2Point(x0, y0), R2Point(x0, y1), R2Point(x1, y1), R2Point(x1, y0)
+    };
+    c.assign(v, 4);
+}
+
+// Intersection of rectangles [0, 1]*[0, 1] and [x0, x1]*[y0, y1]
+static int intersectionSize(double x0, double y0, double x1, double y1) {
+    R2Convex a, b, c;
+    rectangle(a, 0., 0., 1., 1.);
+    rectangle(b, x0, y0, x1, y1);
+    c.intersection(a, b);
+    return c.size();
+}
+
+static void testRectangles() {
+    check(
+        intersectionSize(1., 0., 2., 1.) == 2 &&
+            intersectionSize(0., 1., 1., 2.) == 2,
+        "intersection: touching edges"
+    );
+    check(
+        intersectionSize(1., 1., 2., 2.) == 1,
+        "intersection: touching vertices"
+    );
+    check(
+        intersectionSize(1. + 5e-8, 0., 2., 1.) == 0 &&
+            intersectionSize(0., 1. + 5e-8, 1., 2.) == 0 &&
+            intersectionSize(0., -1., 1., -5e-8) == 0,
+        "intersection: separated by 5e-8"
+    );
+    R2Convex a, b, c;
+    rectangle(a, 0., 0., 1., 1.);
+    rectangle(b, 0.25, 0.5, 0.75, 0.75);
+    c.intersection(a, b);
+    check(
+        c.size() == 4 && c.area() == b.area() &&
+            c.perimeter() == b.perimeter(),
+        "intersection: contained"
+    );
+    c.intersection(b, a);
+    check(c.size() == 4 && c.area() == b.area(), "intersection: container");
+}
+
+// The triangle (0, 0), (s, 0.37s), (2s, 0) and the line segment
+// with the ends on its edge [(0, 0), (s, 0.37s)] moved up by the gap
+static void testSegment(double s, double gap, int size, const char* name) {
+    R2Point v[3] = {
+        R2Point(0., 0.), R2Point(s, 0.37*s), R2Point(2.*s, 0.)
+    };
+    R2Convex t;
+    t.assign(v, 3);
+    R2Point e[2] = {
+        R2Point(0.1*s, 0.037*s + gap), R2Point(0.7*s, 0.259*s + gap)
+    };
+    R2Convex segment;
+    segment.assign(e, 2);
+    R2Convex c;
+    c.intersection(t, segment);
+    bool ok = (c.size() == size);
+    c.intersection(segment, t);
+    ok = ok && (c.size() == size);
+    check(ok, name);
+}
+
+static void testSegments() {
+    testSegment(1., 0., 2, "intersection: segment on edge");
+    testSegment(1e-6, 0., 2, "intersection: segment on edge, scale 1e-6");
+    testSegment(1e6, 0., 2, "intersection: segment on edge, scale 1e6");
+    testSegment(1., 5e-8, 0, "intersection: segment above edge");
+    testSegment(1e-6, 5e-14, 0, "intersection: segment above, scale 1e-6");
+    testSegment(1e6, 5e-2, 0, "intersection: segment above, scale 1e6");
+    testSegment(1., -5e-8, 2, "intersection: segment inside");
+}
+
+// Uniform in [0, 1) (xorshift64*, as in convbench)
+static double uniform(unsigned long long& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    unsigned long long r = state * 2685821657736338717ULL;
+    return (double)(r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// The convex built by addPoint has the same area as the one
+// built from the whole array, and the area is at most maxArea
+static void checkHull(
+    const std::vector<R2Point>& points, double maxArea, const char* name
+) {
+    R2Convex added, built;
+    for (size_t i = 0; i < points.size(); ++i)
+        added.addPoint(points[i]);
+    built.build(&(points[0]), (int) points.size());
+    check(
+        fabs(added.area() - built.area()) <= 1e-9 &&
+            added.area() <= maxArea,
+        name
+    );
+}
+
+// Dense points: a point almost collinear with an edge
+// must not light it from inside
+static void testDense() {
+    unsigned long long state = 0x9E3779B97F4A7C16ULL;
+    std::vector<R2Point> points;
+    for (int i = 0; i < 1000; ++i) {
+        double phi = 2. * M_PI * uniform(state);
+        points.push_back(R2Point(cos(phi), sin(phi)));
+    }
+    checkHull(points, M_PI, "addPoint: 1000 points on the unit circle");
+    points.clear();
+    for (int i = 0; i < 1000000; ++i) {
+        double x = uniform(state);
+        points.push_back(R2Point(x, uniform(state)));
+    }
+    checkHull(points, 1., "addPoint: 10^6 points in the unit square");
+}
+
+int main() {
+    testRectangles();
+    testSegments();
+    testDense();
+    printf("%d failed\n", failures);
+    return (failures != 0);
+}
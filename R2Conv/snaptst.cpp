@@ -0,0 +1,130 @@
+//
+// Test of the hull shared by a writer and readers
+//
+#include <stdio.h>
+#include <math.h>
+#include <thread>
+#include <atomic>
+#include "SnapConv.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name) {
+    printf("%-50s %s\n", name, ok? "ok" : "FAILED");
+    if (!ok)
+        ++failures;
+}
+
+// The snapshot has the same vertices, area and perimeter as c
+static bool sameHull(const R2SharedConvex::Snapshot& s, const R2Convex& c) {
+    if (
+        s->size() != c.size() || s->area() != c.area() ||
+        s->perimeter() != c.perimeter()
+    )
+        return false;
+    R2PointSpan span[2];
+    int numSpans = c.spans(span[0], span[1]);
+    int i = 0;
+    for (int k = 0; k < numSpans; ++k) {
+        for (const R2Point* p = span[k].begin(); p != span[k].end(); ++p) {
+            if ((*s)[i].x != p->x || (*s)[i].y != p->y)
+                return false;
+            ++i;
+        }
+    }
+    return true;
+}
+
+static void testPublish() {
+    R2SharedConvex s;
+    check(
+        s.snapshot()->size() == 0 && s.version() == 0,
+        "snapshot: empty at start"
+    );
+    s.addPoint(R2Point(0., 0.));
+    s.addPoint(R2Point(4., 0.));
+    R2SharedConvex::Snapshot segment = s.snapshot();
+    s.addPoint(R2Point(0., 4.));
+    s.addPoint(R2Point(4., 4.));
+    check(
+        segment->size() == 2 && s.snapshot()->size() == 4 &&
+            s.version() == 4,
+        "snapshot: not changed by the writer"
+    );
+    s.addPoint(R2Point(1., 1.));
+    s.addPoint(R2Point(4., 2.));
+    s.addPoint(R2Point(0., 0.));
+    check(s.version() == 4, "snapshot: points inside are not published");
+    R2SharedConvex::Snapshot square = s.snapshot();
+    check(
+        sameHull(square, s.convex()) && square->area() == 16. &&
+            square->contains(R2Point(2., 3.)) &&
+            !square->contains(R2Point(5., 3.)) &&
+            square->distance(R2Point(7., 0.)) == 3.,
+        "snapshot: vertices and queries"
+    );
+
+    s.setAutoPublish(false);
+    s.addPoint(R2Point(2., 6.));
+    bool delayed = (s.snapshot()->size() == 4 && s.version() == 4);
+    s.publish();
+    s.publish();
+    check(
+        delayed && s.version() == 5 && sameHull(s.snapshot(), s.convex()),
+        "snapshot: publish()"
+    );
+}
+
+// Uniform in [0, 1) (xorshift64*, as in convbench)
+static double uniform(unsigned long long& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    unsigned long long r = state * 2685821657736338717ULL;
+    return (double)(r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// A reader sees the area growing with the version, while
+// the writer adds the points in the unit disk
+static void testReaders() {
+    const int NUM_READERS = 2;
+    R2SharedConvex s;
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+    std::thread readers[NUM_READERS];
+    for (int r = 0; r < NUM_READERS; ++r) {
+        readers[r] = std::thread([&s, &done, &errors]() {
+            long version = (-1);
+            double area = 0.;
+            while (!done.load()) {
+                long v = s.version();
+                R2SharedConvex::Snapshot snap = s.snapshot();
+                if (v < version || snap->area() < area)
+                    ++errors;
+                if (snap->size() > 0 && !snap->contains((*snap)[0]))
+                    ++errors;
+                version = v; area = snap->area();
+            }
+        });
+    }
+    unsigned long long state = 12345;
+    for (int i = 0; i < 100000; ++i) {
+        double r = sqrt(uniform(state));
+        double phi = 2. * M_PI * uniform(state);
+        s.addPoint(R2Point(r * cos(phi), r * sin(phi)));
+    }
+    done.store(true);
+    for (int r = 0; r < NUM_READERS; ++r)
+        readers[r].join();
+    check(
+        errors.load() == 0 && sameHull(s.snapshot(), s.convex()),
+        "snapshot: concurrent readers"
+    );
+}
+
+int main() {
+    testPublish();
+    testReaders();
+    printf("%d failed\n", failures);
+    return (failures != 0);
+}
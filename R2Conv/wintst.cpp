@@ -0,0 +1,101 @@
+//
+// Test of the convex hull of a sliding window
+//
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "WinConv.h"
+#include "R2Conv.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name) {
+    printf("%-50s %s\n", name, ok? "ok" : "FAILED");
+    if (!ok)
+        ++failures;
+}
+
+// Uniform in [0, 1) (xorshift64*, as in convbench)
+static double uniform(unsigned long long& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    unsigned long long r = state * 2685821657736338717ULL;
+    return (double)(r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// The hull of the window is the hull of its points built anew
+static bool sameAsBuilt(
+    const R2WindowConvex& w, const std::vector<R2Point>& points,
+    int first
+) {
+    R2Convex c;
+    c.build(&(points[first]), (int) points.size() - first);
+    return (
+        w.numPoints() == (int) points.size() - first &&
+        w.size() == c.size() &&
+        fabs(w.area() - c.area()) <= 1e-12 &&
+        fabs(w.perimeter() - c.perimeter()) <= 1e-12
+    );
+}
+
+static void testCount() {
+    const int WINDOW = 50;
+    R2WindowConvex w(WINDOW);
+    std::vector<R2Point> points;
+    unsigned long long state = 1;
+    bool ok = true;
+    for (int i = 0; i < 2000; ++i) {
+        double x = uniform(state);
+        points.push_back(R2Point(x, uniform(state)));
+        w.addPoint(points.back());
+        int first = (i+1 > WINDOW? i+1 - WINDOW : 0);
+        if (!sameAsBuilt(w, points, first))
+            ok = false;
+    }
+    check(ok, "window: last 50 points");
+}
+
+// Points on a circle arrive one per second: the hull keeps
+// the points of the last 10 seconds
+static void testAge() {
+    R2WindowConvex w(0, 10.);
+    std::vector<R2Point> points;
+    bool ok = true;
+    for (int i = 0; i < 100; ++i) {
+        double phi = 0.1 * i;
+        points.push_back(R2Point(cos(phi), sin(phi)));
+        w.addPoint(points.back(), (double) i);
+        int first = (i > 10? i - 10 : 0);
+        if (!sameAsBuilt(w, points, first) || w.newest().time != i)
+            ok = false;
+    }
+    int expired = w.expire(104.5);
+    ok = ok && expired == 6 && w.oldest().time == 95. &&
+        sameAsBuilt(w, points, 95);
+    check(ok, "window: points not older than 10 seconds");
+}
+
+static void testRemove() {
+    R2WindowConvex w;
+    w.addPoint(R2Point(0., 0.));
+    w.addPoint(R2Point(2., 0.));
+    w.addPoint(R2Point(0., 2.));
+    w.addPoint(R2Point(1., 1.));
+    bool ok = (w.numPoints() == 4 && w.size() == 3 && w.area() == 2.);
+    ok = ok && w.removeOldest() && w.size() == 2 && w.area() == 0.;
+    while (w.removeOldest())
+        ;
+    check(
+        ok && w.empty() && w.size() == 0 && !w.removeOldest(),
+        "window: remove the oldest points"
+    );
+}
+
+int main() {
+    testCount();
+    testAge();
+    testRemove();
+    printf("%d failed\n", failures);
+    return (failures != 0);
+}
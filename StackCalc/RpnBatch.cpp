@@ -0,0 +1,227 @@
+//
+// Batch evaluation of independent programs of the stack calculator
+// by a pool of threads
+//
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include "RealStack.h"
+#include "RpnBatch.h"
+#include "RpnProgram.h"
+#include "RpnInterp.h"
+#include "RpnTokenizer.h"
+#include "RpnOutput.h"
+#include "RpnDictionary.h"
+
+// Number of programs taken by a worker at once
+const int BATCH_CHUNK_SIZE = 16;
+
+// The worker is aligned to a cache line, so that the ranges
+// of different workers do not share a line
+class alignas(64) RpnBatchWorker {
+public:
+    std::mutex      lock;       // Of the range
+    int             next;       // Range of programs not taken yet
+    int             end;
+    RealStack       stack;
+    RpnDictionary   dictionary;
+    RpnProgram      program;
+    RpnOutput       ignored;    // "=" and "show" are ignored
+    std::thread     thread;
+
+    RpnBatchWorker():
+        lock(),
+        next(0),
+        end(0),
+        stack(),
+        dictionary(),
+        program(&dictionary),
+        ignored(-1, 64),
+        thread()
+    {}
+
+    void execute(const char* text, size_t length, RpnBatchResult& result);
+};
+
+RpnBatchEvaluator::RpnBatchEvaluator(int threads /* = 0 */):
+    workers(),
+    mutex(),
+    started(),
+    finished(),
+    generation(0),
+    running(0),
+    stopping(false),
+    texts(0),
+    lengths(0),
+    results(0)
+{
+    if (threads <= 0)
+        threads = (int) std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+    for (int w = 0; w < threads; ++w)
+        workers.push_back(new RpnBatchWorker());
+    // The worker 0 is the calling thread
+    for (int w = 1; w < threads; ++w)
+        workers[w]->thread = std::thread(&RpnBatchEvaluator::run, this, w);
+}
+
+RpnBatchEvaluator::~RpnBatchEvaluator() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (size_t w = 0; w < workers.size(); ++w) {
+        if (workers[w]->thread.joinable())
+            workers[w]->thread.join();
+        delete workers[w];
+    }
+}
+
+void RpnBatchEvaluator::evaluate(
+    const char* const* programTexts, const size_t* programLengths, int n,
+    RpnBatchResult* programResults
+) {
+    if (n <= 0)
+        return;
+    texts = programTexts;
+    lengths = programLengths;
+    results = programResults;
+    int numWorkers = (int) workers.size();
+    for (int w = 0; w < numWorkers; ++w) {
+        RpnBatchWorker* worker = workers[w];
+        std::lock_guard<std::mutex> guard(worker->lock);
+        worker->next = (int)((long long) n * w / numWorkers);
+        worker->end = (int)((long long) n * (w + 1) / numWorkers);
+    }
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        running = numWorkers - 1;
+        ++generation;
+    }
+    started.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> guard(mutex);
+    while (running > 0)
+        finished.wait(guard);
+}
+
+// Thread of the worker w > 0: wait for a batch, work on it
+void RpnBatchEvaluator::run(int w) {
+    unsigned done = 0;      // Last generation worked on
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(mutex);
+            while (!stopping && generation == done)
+                started.wait(guard);
+            if (stopping)
+                return;
+            done = generation;
+        }
+        work(w);
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            --running;
+            if (running == 0)
+                finished.notify_one();
+        }
+    }
+}
+
+void RpnBatchEvaluator::work(int w) {
+    RpnBatchWorker* worker = workers[w];
+    int first, last;
+    while (take(w, first, last)) {
+        for (int i = first; i < last; ++i) {
+            worker->execute(
+                texts[i], (lengths != 0? lengths[i] : strlen(texts[i])),
+                results[i]
+            );
+        }
+    }
+}
+
+// Take the next chunk of the range of worker w or steal a range.
+// Return value: false, if no programs are left
+bool RpnBatchEvaluator::take(int w, int& first, int& last) {
+    RpnBatchWorker* worker = workers[w];
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(worker->lock);
+            if (worker->next < worker->end) {
+                first = worker->next;
+                last = first + BATCH_CHUNK_SIZE;
+                if (last > worker->end)
+                    last = worker->end;
+                worker->next = last;
+                return true;
+            }
+        }
+        if (!steal(w))
+            return false;
+    }
+}
+
+// Move the second half of the largest range left to the worker w.
+// The ranges only shrink during a batch, so when all of them are
+// empty, every program is taken by some worker.
+// Return value: false, if all ranges are empty
+bool RpnBatchEvaluator::steal(int w) {
+    int numWorkers = (int) workers.size();
+    int victim = -1;
+    int largest = 0;
+    for (int v = 0; v < numWorkers; ++v) {
+        if (v == w)
+            continue;
+        std::lock_guard<std::mutex> guard(workers[v]->lock);
+        int left = workers[v]->end - workers[v]->next;
+        if (left > largest) {
+            largest = left;
+            victim = v;
+        }
+    }
+    if (victim < 0)
+        return false;
+
+    int first, last;
+    {
+        RpnBatchWorker* v = workers[victim];
+        std::lock_guard<std::mutex> guard(v->lock);
+        last = v->end;
+        first = last - (last - v->next + 1) / 2;
+        v->end = first;     // An empty range is left, if it is taken
+    }                       // meanwhile; then the thief tries again
+    RpnBatchWorker* worker = workers[w];
+    std::lock_guard<std::mutex> guard(worker->lock);
+    worker->next = first;
+    worker->end = last;
+    return true;
+}
+
+void RpnBatchWorker::execute(
+    const char* text, size_t length, RpnBatchResult& result
+) {
+    result.value = NAN;
+    result.error.clear();
+    program.clear();
+    dictionary.clear();
+    stack.clear();
+    try {
+        RpnTokenizer tokens(text, length);
+        program.compile(tokens);
+        rpnExecute(program, stack, 0, 0, &ignored, RPN_MAX_JUMPS);
+        if (stack.empty())
+            throw StackException("Stack empty");
+        result.value = stack.top();
+    } catch (RpnSyntaxException& e) {
+        result.error = e.reason;
+        if (!e.token.empty()) {
+            result.error += ": ";
+            result.error += e.token;
+        }
+    } catch (StackException& e) {
+        result.error = "Stack Exception: ";
+        result.error += e.reason;
+    }
+}
@@ -0,0 +1,75 @@
+//
+// Batch evaluation of independent programs of the stack calculator
+// by a pool of threads
+//
+#ifndef RPN_BATCH_H
+#define RPN_BATCH_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// Result of a program: the top of stack at the end
+class RpnBatchResult {
+public:
+    double      value;      // NaN after an error
+    std::string error;      // Message or empty
+};
+
+class RpnBatchWorker;
+
+//
+// Every program is compiled and executed from the empty stack with
+// its own words and variables, as by a separate StackCalc process;
+// the commands "=" and "show" are ignored, and a program fails after
+// RPN_MAX_JUMPS repetitions of loops (see "RpnInterp.h"). The programs
+// are divided among the workers in contiguous ranges; a worker takes
+// its programs from the beginning of its range by small chunks, and
+// a worker that has finished its range steals the second half of the
+// largest range left. Every worker owns its stack, program and
+// dictionary, which are reused from one program to the next, so
+// the workers share nothing but the ranges. The calling thread is
+// one of the workers.
+//
+class RpnBatchEvaluator {
+    std::vector<RpnBatchWorker*> workers;
+    std::mutex mutex;
+    std::condition_variable started;    // A batch or the end
+    std::condition_variable finished;   // All threads are idle
+    unsigned generation;    // Number of batches started
+    int running;            // Threads working on the batch
+    bool stopping;
+
+    // Current batch
+    const char* const* texts;
+    const size_t* lengths;
+    RpnBatchResult* results;
+
+public:
+    // The number of threads 0 means the number of processors
+    RpnBatchEvaluator(int threads = 0);
+    ~RpnBatchEvaluator();
+
+    // Compute n programs; the text of program i is texts[i]
+    // (lengths[i] characters, or up to the null character,
+    // if lengths is 0), and its result is results[i]
+    void evaluate(
+        const char* const* texts, const size_t* lengths, int n,
+        RpnBatchResult* results
+    );
+
+    int threads() const { return (int) workers.size(); }
+
+private:
+    RpnBatchEvaluator(const RpnBatchEvaluator&);            // Not implemented
+    RpnBatchEvaluator& operator=(const RpnBatchEvaluator&); // Not implemented
+
+    void run(int w);
+    void work(int w);
+    bool take(int w, int& first, int& last);
+    bool steal(int w);
+};
+
+#endif
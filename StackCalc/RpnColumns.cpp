@@ -0,0 +1,439 @@
+//
+// Columnar evaluation of programs of the stack calculator
+//
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+#include "RealStack.h"
+#include "RpnColumns.h"
+#include "RpnInterp.h"
+#include "RpnDictionary.h"
+#include "RpnMath.h"
+
+//
+// Kernels: dst[i] = a[i] op b[i], where a or b may be a scalar.
+// The pointers may coincide with dst (the operation is in place).
+//
+
+class AddOp {
+public:
+    static double apply(double x, double y) { return x + y; }
+#ifdef __SSE2__
+    static __m128d apply(__m128d x, __m128d y) { return _mm_add_pd(x, y); }
+#endif
+};
+
+class SubOp {
+public:
+    static double apply(double x, double y) { return x - y; }
+#ifdef __SSE2__
+    static __m128d apply(__m128d x, __m128d y) { return _mm_sub_pd(x, y); }
+#endif
+};
+
+class MulOp {
+public:
+    static double apply(double x, double y) { return x * y; }
+#ifdef __SSE2__
+    static __m128d apply(__m128d x, __m128d y) { return _mm_mul_pd(x, y); }
+#endif
+};
+
+class DivOp {
+public:
+    static double apply(double x, double y) { return x / y; }
+#ifdef __SSE2__
+    static __m128d apply(__m128d x, __m128d y) { return _mm_div_pd(x, y); }
+#endif
+};
+
+class PowOp {
+public:
+    static double apply(double x, double y) { return rpnPow(x, y); }
+#ifdef __SSE2__
+    static __m128d apply(__m128d x, __m128d y) { return rpnPow(x, y); }
+#endif
+};
+
+class Atan2Op {
+public:
+    static double apply(double x, double y) { return rpnAtan2(x, y); }
+#ifdef __SSE2__
+    static __m128d apply(__m128d x, __m128d y) { return rpnAtan2(x, y); }
+#endif
+};
+
+// Comparisons give 1 or 0: the mask of comparison and 1
+#define RPN_COMPARISON_OP(Name, op, sseCompare)                         \
+class Name {                                                            \
+public:                                                                 \
+    static double apply(double x, double y) { return (x op y? 1. : 0.); } \
+    RPN_COMPARISON_SSE(sseCompare)                                      \
+};
+
+#ifdef __SSE2__
+#   define RPN_COMPARISON_SSE(sseCompare)                               \
+    static __m128d apply(__m128d x, __m128d y) {                        \
+        return _mm_and_pd(sseCompare(x, y), _mm_set1_pd(1.));           \
+    }
+#else
+#   define RPN_COMPARISON_SSE(sseCompare)
+#endif
+
+RPN_COMPARISON_OP(LtOp, <, _mm_cmplt_pd)
+RPN_COMPARISON_OP(GtOp, >, _mm_cmpgt_pd)
+RPN_COMPARISON_OP(LeOp, <=, _mm_cmple_pd)
+RPN_COMPARISON_OP(GeOp, >=, _mm_cmpge_pd)
+RPN_COMPARISON_OP(EqOp, ==, _mm_cmpeq_pd)
+RPN_COMPARISON_OP(NeOp, !=, _mm_cmpneq_pd)
+
+#undef RPN_COMPARISON_OP
+#undef RPN_COMPARISON_SSE
+
+template <class Op, bool ScalarA, bool ScalarB>
+static void kernel(
+    double* dst, const double* a, double sa, const double* b, double sb,
+    int n
+) {
+    int i = 0;
+#ifdef __SSE2__
+    __m128d va = _mm_set1_pd(sa);
+    __m128d vb = _mm_set1_pd(sb);
+    for (; i + 4 <= n; i += 4) {
+        __m128d x0 = ScalarA? va : _mm_loadu_pd(a + i);
+        __m128d x1 = ScalarA? va : _mm_loadu_pd(a + i + 2);
+        __m128d y0 = ScalarB? vb : _mm_loadu_pd(b + i);
+        __m128d y1 = ScalarB? vb : _mm_loadu_pd(b + i + 2);
+        _mm_storeu_pd(dst + i, Op::apply(x0, y0));
+        _mm_storeu_pd(dst + i + 2, Op::apply(x1, y1));
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] = Op::apply(ScalarA? sa : a[i], ScalarB? sb : b[i]);
+}
+
+template <class Op>
+static void binary(
+    double* dst, const RpnColumnEvaluator::Slot& a,
+    const RpnColumnEvaluator::Slot& b, int n
+) {
+    if (a.scalar)
+        kernel<Op, true, false>(dst, 0, a.value, b.data, 0., n);
+    else if (b.scalar)
+        kernel<Op, false, true>(dst, a.data, 0., 0, b.value, n);
+    else
+        kernel<Op, false, false>(dst, a.data, 0., b.data, 0., n);
+}
+
+// Operation on scalars
+static double compute(int op, double x, double y) {
+    switch (op) {
+    case RPN_ADD: return x + y;
+    case RPN_SUB: return x - y;
+    case RPN_MUL: return x * y;
+    case RPN_DIV: return x / y;
+    case RPN_LT:  return LtOp::apply(x, y);
+    case RPN_GT:  return GtOp::apply(x, y);
+    case RPN_LE:  return LeOp::apply(x, y);
+    case RPN_GE:  return GeOp::apply(x, y);
+    case RPN_EQ:  return EqOp::apply(x, y);
+    case RPN_NE:  return NeOp::apply(x, y);
+    case RPN_POW: return rpnPow(x, y);
+    case RPN_ATAN2: return rpnAtan2(x, y);
+    case RPN_SIN: return rpnSin(x);
+    case RPN_COS: return rpnCos(x);
+    case RPN_EXP: return rpnExp(x);
+    case RPN_LOG: return rpnLog(x);
+    case RPN_SQRT: return rpnSqrt(x);
+    default:      return fmod(x, y);
+    }
+}
+
+// Functions of a column (see "RpnMath.h")
+static void unary(int op, double* dst, const double* a, int n) {
+    switch (op) {
+    case RPN_SIN: rpnSin(dst, a, n); break;
+    case RPN_COS: rpnCos(dst, a, n); break;
+    case RPN_EXP: rpnExp(dst, a, n); break;
+    case RPN_LOG: rpnLog(dst, a, n); break;
+    default:      rpnSqrt(dst, a, n); break;
+    }
+}
+
+static void modKernel(
+    double* dst, const RpnColumnEvaluator::Slot& a,
+    const RpnColumnEvaluator::Slot& b, int n
+) {
+    for (int i = 0; i < n; ++i) {
+        dst[i] = fmod(
+            a.scalar? a.value : a.data[i],
+            b.scalar? b.value : b.data[i]
+        );
+    }
+}
+
+// Choose the size of block by the size of L1 data cache:
+// the columns of stack of a block take about half of it
+void RpnColumnEvaluator::prepare(const RpnProgram& program) {
+    if (!program.canRun(0))
+        throw StackException("Stack empty");
+    int depth = program.maxDepth(0);
+    if (depth < 1)
+        depth = 1;
+    if (blockSize <= 0) {
+        long l1 = 0;
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+        l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+#endif
+        if (l1 <= 0)
+            l1 = 32768;
+        long b = l1 / 2 / ((long) sizeof(double) * depth);
+        if (b < 64)
+            b = 64;
+        else if (b > 4096)
+            b = 4096;
+        blockSize = (int)(b & ~7L);
+    }
+    storage.resize((size_t) depth * blockSize);
+    buffers.resize(depth);
+    references.assign(depth, 0);
+    for (int i = 0; i < depth; ++i)
+        buffers[i] = &(storage[(size_t) i * blockSize]);
+    slots.resize(depth + 1);    // The constant of PUSH_ADD ... PUSH_DIV
+}
+
+// Buffer for the result of operation on the slots a and b
+// (released before): the buffer of a or b, if it is not used
+// by other slots, or a free one
+int RpnColumnEvaluator::allocate(const Slot& a, const Slot& b) {
+    if (a.buffer >= 0 && references[a.buffer] == 0)
+        return a.buffer;
+    if (b.buffer >= 0 && references[b.buffer] == 0)
+        return b.buffer;
+    for (int i = 0; i < (int) references.size(); ++i) {
+        if (references[i] == 0)
+            return i;
+    }
+    assert(false);      // There are at most maxDepth buffers in use
+    return 0;
+}
+
+void RpnColumnEvaluator::release(const Slot& s) {
+    if (s.buffer >= 0)
+        --references[s.buffer];
+}
+
+void RpnColumnEvaluator::evaluate(
+    const RpnProgram& program,
+    const double* const* columns, int n,
+    double* result
+) {
+    if (!program.simple()) {
+        evaluateRows(program, columns, n, result);
+        return;
+    }
+    prepare(program);
+    for (int first = 0; first < n; first += blockSize) {
+        int len = n - first;
+        if (len > blockSize)
+            len = blockSize;
+        evaluateBlock(program, columns, first, len, result + first);
+    }
+}
+
+// The program with jumps, calls of words or assignments is executed
+// by the interpreter for every record
+void RpnColumnEvaluator::evaluateRows(
+    const RpnProgram& program,
+    const double* const* columns, int n,
+    double* result
+) {
+    int k = program.columns();
+    std::vector<double> fields(k > 0? k : 1);
+    RpnOutput ignored(-1, 64);  // "=" and "show" are ignored
+    RealStack stack;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < k; ++j)
+            fields[j] = columns[j][i];
+        stack.clear();
+        rpnExecute(program, stack, &(fields[0]), k, &ignored);
+        if (stack.empty())
+            throw StackException("Stack empty");
+        result[i] = stack.top();
+    }
+}
+
+void RpnColumnEvaluator::evaluateBlock(
+    const RpnProgram& program,
+    const double* const* columns, int first, int n,
+    double* result
+) {
+    const RpnInstruction* pc = program.instructions();
+    const double* constants = program.constantPool();
+    const double* variables = 0;
+    if (program.getDictionary() != 0)
+        variables = program.getDictionary()->variableTable();
+    Slot* sp = &(slots[0]);     // Above the top of stack
+    Slot* base = sp;
+    for (size_t i = 0; i < references.size(); ++i)
+        references[i] = 0;
+
+    while (true) {
+        RpnInstruction w = *pc++;
+        int op = rpnOpcode(w);
+        switch (op) {
+        case RPN_PUSH:
+            sp->scalar = true;
+            sp->value = constants[rpnOperand(w)];
+            sp->data = 0;
+            sp->buffer = (-1);
+            ++sp;
+            break;
+        case RPN_COLUMN:
+            sp->scalar = false;
+            sp->data = columns[rpnOperand(w)] + first;
+            sp->buffer = (-1);
+            ++sp;
+            break;
+        case RPN_FETCH:
+            sp->scalar = true;
+            sp->value = variables[rpnOperand(w)];
+            sp->data = 0;
+            sp->buffer = (-1);
+            ++sp;
+            break;
+        case RPN_PUSH_ADD:
+        case RPN_PUSH_SUB:
+        case RPN_PUSH_MUL:
+        case RPN_PUSH_DIV:
+            // The constant operand, then the operation
+            sp->scalar = true;
+            sp->value = constants[rpnOperand(w)];
+            sp->data = 0;
+            sp->buffer = (-1);
+            ++sp;
+            op = RPN_ADD + (op - RPN_PUSH_ADD);
+            // Fall through
+        case RPN_ADD:
+        case RPN_SUB:
+        case RPN_MUL:
+        case RPN_DIV:
+        case RPN_MOD:
+        case RPN_POW:
+        case RPN_ATAN2:
+        case RPN_LT:
+        case RPN_GT:
+        case RPN_LE:
+        case RPN_GE:
+        case RPN_EQ:
+        case RPN_NE:
+            {
+                Slot b = *(--sp);
+                Slot a = sp[-1];
+                Slot& r = sp[-1];
+                if (a.scalar && b.scalar) {
+                    // Constant subexpression
+                    r.value = compute(op, a.value, b.value);
+                    break;
+                }
+                release(a); release(b);
+                int buf = allocate(a, b);
+                double* dst = buffers[buf];
+                if (op == RPN_ADD)
+                    binary<AddOp>(dst, a, b, n);
+                else if (op == RPN_SUB)
+                    binary<SubOp>(dst, a, b, n);
+                else if (op == RPN_MUL)
+                    binary<MulOp>(dst, a, b, n);
+                else if (op == RPN_DIV)
+                    binary<DivOp>(dst, a, b, n);
+                else if (op == RPN_MOD)
+                    modKernel(dst, a, b, n);
+                else if (op == RPN_POW)
+                    binary<PowOp>(dst, a, b, n);
+                else if (op == RPN_ATAN2)
+                    binary<Atan2Op>(dst, a, b, n);
+                else if (op == RPN_LT)
+                    binary<LtOp>(dst, a, b, n);
+                else if (op == RPN_GT)
+                    binary<GtOp>(dst, a, b, n);
+                else if (op == RPN_LE)
+                    binary<LeOp>(dst, a, b, n);
+                else if (op == RPN_GE)
+                    binary<GeOp>(dst, a, b, n);
+                else if (op == RPN_EQ)
+                    binary<EqOp>(dst, a, b, n);
+                else
+                    binary<NeOp>(dst, a, b, n);
+                r.scalar = false;
+                r.data = dst;
+                r.buffer = buf;
+                ++references[buf];
+            }
+            break;
+        case RPN_SIN:
+        case RPN_COS:
+        case RPN_EXP:
+        case RPN_LOG:
+        case RPN_SQRT:
+            {
+                Slot a = sp[-1];
+                Slot& r = sp[-1];
+                if (a.scalar) {
+                    r.value = compute(op, a.value, 0.);
+                    break;
+                }
+                release(a);
+                int buf = allocate(a, a);
+                double* dst = buffers[buf];
+                unary(op, dst, a.data, n);
+                r.data = dst;
+                r.buffer = buf;
+                ++references[buf];
+            }
+            break;
+        case RPN_POP:
+            release(*(--sp));
+            break;
+        case RPN_DUP:
+            *sp = sp[-1];
+            if (sp->buffer >= 0)
+                ++references[sp->buffer];
+            ++sp;
+            break;
+        case RPN_EXCH:
+            {
+                Slot s = sp[-1];
+                sp[-1] = sp[-2];
+                sp[-2] = s;
+            }
+            break;
+        case RPN_CLEAR:
+            while (sp > base)
+                release(*(--sp));
+            break;
+        case RPN_DISPLAY:
+        case RPN_SHOW:
+        case RPN_STATS:
+            break;
+        default:
+            assert(false);      // Not a simple program
+            break;
+        case RPN_QUIT:
+        case RPN_END:
+            if (sp == base)
+                throw StackException("Stack empty");
+            if (sp[-1].scalar) {
+                for (int i = 0; i < n; ++i)
+                    result[i] = sp[-1].value;
+            } else {
+                memcpy(result, sp[-1].data, n * sizeof(double));
+            }
+            return;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+//
+// Columnar evaluation of programs of the stack calculator:
+// every element of stack is a column of values instead of
+// a single number, so that one pass of the program computes
+// its result for many records.
+//
+#ifndef RPN_COLUMNS_H
+#define RPN_COLUMNS_H
+
+#include <vector>
+#include "RpnProgram.h"
+
+//
+// The records are processed by blocks, so that the columns of
+// stack of a block fit into L1 cache; the arithmetic of a block
+// is done by SIMD kernels. The constants are not expanded to
+// columns, and $k refers to the input column without copying.
+// The program must begin with the empty stack; the commands
+// "=" and "show" are ignored. The programs with jumps, calls
+// of words or assignments of variables (see RpnProgram::simple)
+// are executed by the interpreter for every record instead.
+//
+class RpnColumnEvaluator {
+public:
+    // Element of stack: a column of a block or a scalar
+    class Slot {
+    public:
+        const double*   data;       // Column of the block
+        double          value;      // Scalar
+        int             buffer;     // Own buffer of data or -1
+        bool            scalar;
+    };
+
+private:
+    int blockSize;
+    std::vector<double> storage;    // Buffers of blocks
+    std::vector<double*> buffers;
+    std::vector<int> references;    // Number of slots using a buffer
+    std::vector<Slot> slots;
+
+public:
+    // The block size 0 means automatic choice by the size of L1
+    RpnColumnEvaluator(int block = 0):
+        blockSize(block),
+        storage(),
+        buffers(),
+        references(),
+        slots()
+    {}
+
+    // Compute the program for n records. The field $k of record i
+    // is columns[k-1][i]; the result (the top of stack) is written
+    // to result[i].
+    // Throws StackException, if the stack is too small for the
+    // program or is empty at the end.
+    void evaluate(
+        const RpnProgram& program,
+        const double* const* columns, int n,
+        double* result
+    );
+
+    int block() const { return blockSize; }
+
+private:
+    void prepare(const RpnProgram& program);
+    void evaluateRows(
+        const RpnProgram& program,
+        const double* const* columns, int n,
+        double* result
+    );
+    void evaluateBlock(
+        const RpnProgram& program,
+        const double* const* columns, int first, int n,
+        double* result
+    );
+    int allocate(const Slot& a, const Slot& b);
+    void release(const Slot& s);
+};
+
+#endif
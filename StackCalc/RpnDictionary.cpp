@@ -0,0 +1,44 @@
+//
+// Dictionary of the stack calculator: words and variables
+//
+#include "RpnProgram.h"
+#include "RpnDictionary.h"
+
+RpnDictionary::~RpnDictionary() {
+    clear();
+}
+
+void RpnDictionary::clear() {
+    for (size_t i = 0; i < words.size(); ++i)
+        delete words[i];
+    words.clear();
+    variables.clear();
+    names.clear();
+}
+
+int RpnDictionary::find(const std::string& name, int& index) const {
+    std::unordered_map<std::string, Entry>::const_iterator i =
+        names.find(name);
+    if (i == names.end())
+        return RPN_NAME_NONE;
+    index = i->second.index;
+    return i->second.kind;
+}
+
+int RpnDictionary::defineWord(const std::string& name, RpnProgram* word) {
+    Entry e;
+    e.kind = RPN_NAME_WORD;
+    e.index = (int) words.size();
+    words.push_back(word);
+    names[name] = e;
+    return e.index;
+}
+
+int RpnDictionary::defineVariable(const std::string& name) {
+    Entry e;
+    e.kind = RPN_NAME_VARIABLE;
+    e.index = (int) variables.size();
+    variables.push_back(0.);
+    names[name] = e;
+    return e.index;
+}
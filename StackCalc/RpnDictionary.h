@@ -0,0 +1,82 @@
+//
+// Dictionary of the stack calculator: words and variables
+//
+#ifndef RPN_DICTIONARY_H
+#define RPN_DICTIONARY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class RpnProgram;
+
+enum RpnNameKind {
+    RPN_NAME_NONE,
+    RPN_NAME_WORD,
+    RPN_NAME_VARIABLE
+};
+
+//
+// The words and variables are numbered in the order of definition
+// and are never removed: a new definition of a name gets a new
+// number, and the programs compiled before keep using the old one.
+// The compiled programs refer to the words and variables by their
+// numbers (see RPN_CALL, RPN_FETCH, RPN_STORE in "RpnProgram.h").
+//
+class RpnDictionary {
+    class Entry {
+    public:
+        int kind;       // RpnNameKind
+        int index;
+    };
+
+    std::unordered_map<std::string, Entry> names;
+    std::vector<RpnProgram*> words;
+    std::vector<double> variables;
+
+public:
+    RpnDictionary():
+        names(),
+        words(),
+        variables()
+    {}
+
+    ~RpnDictionary();
+
+    // Remove all words and variables
+    void clear();
+
+    // Kind of the name (RpnNameKind); index is the number of
+    // the word or variable
+    int find(const std::string& name, int& index) const;
+
+    // The dictionary owns the word (compiled by RpnProgram::compile).
+    // Return value: the number of word
+    int defineWord(const std::string& name, RpnProgram* word);
+
+    // The value of new variable is 0.
+    // Return value: the number of variable
+    int defineVariable(const std::string& name);
+
+    int numWords() const { return (int) words.size(); }
+    const RpnProgram& word(int i) const { return *(words[i]); }
+    const RpnProgram* const* wordTable() const {
+        return (words.empty()? 0 : &(words[0]));
+    }
+
+    int numVariables() const { return (int) variables.size(); }
+    double variable(int i) const { return variables[i]; }
+    void setVariable(int i, double x) { variables[i] = x; }
+
+    // The array of values of variables; it moves, when a variable
+    // is defined
+    double* variableTable() {
+        return (variables.empty()? 0 : &(variables[0]));
+    }
+
+private:
+    RpnDictionary(const RpnDictionary&);            // Not implemented
+    RpnDictionary& operator=(const RpnDictionary&); // Not implemented
+};
+
+#endif
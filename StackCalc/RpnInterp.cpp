@@ -0,0 +1,316 @@
+//
+// Interpreter of compiled programs of the stack calculator.
+// With GNU C++, the dispatch is threaded: every instruction jumps
+// directly to the code of the next one through a table of labels
+// (computed goto), so that there is an indirect jump per instruction
+// instead of a jump to the common switch. Define RPN_SWITCH_DISPATCH
+// to use the switch anyway.
+//
+// With RPN_PROFILE defined, every dispatch is counted (see
+// "RpnProfile.h"); otherwise RPN_PROFILE_STEP is empty.
+//
+#include <math.h>
+#include "RpnInterp.h"
+#include "RpnDictionary.h"
+#include "RpnMath.h"
+#include "RpnProfile.h"
+
+#if defined(__GNUC__) && !defined(RPN_SWITCH_DISPATCH)
+#   define RPN_THREADED_DISPATCH
+#endif
+
+static void display(RpnOutput& out, const double* base, const double* sp) {
+    if (sp > base) {
+        out.put("= ");
+        out.putNumber(sp[-1]);
+        out.put('\n');
+    } else {
+        out.put("stack empty\n");
+    }
+}
+
+static void show(RpnOutput& out, const double* base, const double* sp) {
+    int d = (int)(sp - base);
+    out.put("Depth of stack = ");
+    out.putInteger(d);
+    if (d > 0)
+        out.put(". Stack elements:\n");
+    else
+        out.put(".\n");
+    for (int i = 0; i < d; i++) {
+        out.put('\t');
+        out.putNumber(sp[-1 - i]);
+        out.put('\n');
+    }
+}
+
+// Return address of a call of word
+class RpnFrame {
+public:
+    const RpnInstruction*   pc;
+    const RpnInstruction*   code;
+    const double*           constants;
+};
+
+// Loop "do"
+class RpnLoopFrame {
+public:
+    double  index;
+    double  limit;
+};
+
+bool rpnExecute(
+    const RpnProgram& program, RealStack& stack,
+    const double* fields /* = 0 */, int numFields /* = 0 */,
+    RpnOutput* output /* = 0 */, long maxJumps /* = 0 */
+) {
+    int depth = stack.size();
+    if (!program.canRun(depth))
+        throw StackException("Stack empty");
+    if (numFields < program.columns())
+        throw StackException("No such field");
+#ifdef RPN_PROFILE
+    RpnProfiler profiler;
+    int capacity = stack.capacity();
+    stack.reserve(program.maxDepth(depth));
+    if (stack.capacity() != capacity)
+        ++profiler.profile.growths;
+#   define RPN_PROFILE_STEP profiler.step(rpnOpcode(w), (int)(sp - base))
+#else
+    stack.reserve(program.maxDepth(depth));
+#   define RPN_PROFILE_STEP
+#endif
+
+    // The stacks of calls and loops have static depths as well
+    Stack<RpnFrame, 16> frames;
+    Stack<RpnLoopFrame, 16> loops;
+    frames.reserve(program.callDepth());
+    loops.reserve(program.loopDepth());
+    RpnFrame* rbase = frames.data();
+    RpnFrame* rp = rbase;
+    RpnLoopFrame* lp = loops.data();
+    RpnDictionary* dictionary = program.getDictionary();
+    const RpnProgram* const* words = 0;
+    double* variables = 0;
+    if (dictionary != 0) {
+        words = dictionary->wordTable();
+        variables = dictionary->variableTable();
+    }
+
+    double* base = stack.data();
+    double* sp = base + depth;      // Above the top of stack
+    const RpnInstruction* code = program.instructions();
+    const RpnInstruction* pc = code;
+    const double* constants = program.constantPool();
+    RpnOutput& out = (output != 0? *output : rpnStandardOutput);
+    RpnInstruction w;
+    bool res = true;
+    long jumps = (maxJumps > 0? maxJumps : (-1));   // -1: no limit
+
+#ifdef RPN_THREADED_DISPATCH
+    static void* const labels[RPN_NUM_OPCODES] = {
+#   define RPN_OPCODE_LABEL(name, pops, pushes) &&L_##name,
+        RPN_OPCODE_LIST(RPN_OPCODE_LABEL)
+#   undef RPN_OPCODE_LABEL
+    };
+#   define RPN_CASE(name)   L_##name:
+#   define RPN_NEXT \
+        w = *pc++; RPN_PROFILE_STEP; goto *labels[rpnOpcode(w)]
+    RPN_NEXT;
+#else
+#   define RPN_CASE(name)   case RPN_##name:
+#   define RPN_NEXT         continue
+    while (true) {
+    w = *pc++;
+    RPN_PROFILE_STEP;
+    switch (rpnOpcode(w)) {
+#endif
+
+    RPN_CASE(PUSH)
+        *sp++ = constants[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(COLUMN)
+        *sp++ = fields[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(ADD)
+        --sp; sp[-1] += sp[0];
+        RPN_NEXT;
+    RPN_CASE(SUB)
+        --sp; sp[-1] -= sp[0];
+        RPN_NEXT;
+    RPN_CASE(MUL)
+        --sp; sp[-1] *= sp[0];
+        RPN_NEXT;
+    RPN_CASE(DIV)
+        --sp; sp[-1] /= sp[0];
+        RPN_NEXT;
+    RPN_CASE(MOD)
+        --sp; sp[-1] = fmod(sp[-1], sp[0]);
+        RPN_NEXT;
+    RPN_CASE(POW)
+        --sp; sp[-1] = rpnPow(sp[-1], sp[0]);
+        RPN_NEXT;
+    RPN_CASE(ATAN2)
+        --sp; sp[-1] = rpnAtan2(sp[-1], sp[0]);
+        RPN_NEXT;
+    RPN_CASE(SIN)
+        sp[-1] = rpnSin(sp[-1]);
+        RPN_NEXT;
+    RPN_CASE(COS)
+        sp[-1] = rpnCos(sp[-1]);
+        RPN_NEXT;
+    RPN_CASE(EXP)
+        sp[-1] = rpnExp(sp[-1]);
+        RPN_NEXT;
+    RPN_CASE(LOG)
+        sp[-1] = rpnLog(sp[-1]);
+        RPN_NEXT;
+    RPN_CASE(SQRT)
+        sp[-1] = rpnSqrt(sp[-1]);
+        RPN_NEXT;
+    RPN_CASE(LT)
+        --sp; sp[-1] = (sp[-1] < sp[0]? 1. : 0.);
+        RPN_NEXT;
+    RPN_CASE(GT)
+        --sp; sp[-1] = (sp[-1] > sp[0]? 1. : 0.);
+        RPN_NEXT;
+    RPN_CASE(LE)
+        --sp; sp[-1] = (sp[-1] <= sp[0]? 1. : 0.);
+        RPN_NEXT;
+    RPN_CASE(GE)
+        --sp; sp[-1] = (sp[-1] >= sp[0]? 1. : 0.);
+        RPN_NEXT;
+    RPN_CASE(EQ)
+        --sp; sp[-1] = (sp[-1] == sp[0]? 1. : 0.);
+        RPN_NEXT;
+    RPN_CASE(NE)
+        --sp; sp[-1] = (sp[-1] != sp[0]? 1. : 0.);
+        RPN_NEXT;
+    RPN_CASE(PUSH_ADD)
+        sp[-1] += constants[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(PUSH_SUB)
+        sp[-1] -= constants[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(PUSH_MUL)
+        sp[-1] *= constants[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(PUSH_DIV)
+        sp[-1] /= constants[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(POP)
+        --sp;
+        RPN_NEXT;
+    RPN_CASE(DUP)
+        sp[0] = sp[-1]; ++sp;
+        RPN_NEXT;
+    RPN_CASE(EXCH)
+        {
+            double x = sp[-1];
+            sp[-1] = sp[-2];
+            sp[-2] = x;
+        }
+        RPN_NEXT;
+    RPN_CASE(CLEAR)
+        sp = base;
+        RPN_NEXT;
+    RPN_CASE(DISPLAY)
+        display(out, base, sp);
+        RPN_NEXT;
+    RPN_CASE(SHOW)
+        show(out, base, sp);
+        RPN_NEXT;
+    RPN_CASE(STATS)
+        rpnProfilePrint(out);
+        RPN_NEXT;
+    RPN_CASE(JMP)
+        if (code + rpnOperand(w) < pc && --jumps == 0)
+            goto exhausted;
+        pc = code + rpnOperand(w);
+        RPN_NEXT;
+    RPN_CASE(JZ)
+        --sp;
+        if (*sp == 0.) {
+            if (code + rpnOperand(w) < pc && --jumps == 0)
+                goto exhausted;
+            pc = code + rpnOperand(w);
+        }
+        RPN_NEXT;
+    RPN_CASE(DO)
+        sp -= 2;
+        if (sp[1] < sp[0]) {
+            lp->index = sp[1];
+            lp->limit = sp[0];
+            ++lp;
+        } else {
+            pc = code + rpnOperand(w);
+        }
+        RPN_NEXT;
+    RPN_CASE(LOOP)
+        lp[-1].index += 1.;
+        if (lp[-1].index < lp[-1].limit) {
+            if (--jumps == 0)
+                goto exhausted;
+            pc = code + rpnOperand(w);
+        } else
+            --lp;
+        RPN_NEXT;
+    RPN_CASE(INDEX)
+        *sp++ = lp[-1].index;
+        RPN_NEXT;
+    RPN_CASE(CALL)
+        {
+            rp->pc = pc;
+            rp->code = code;
+            rp->constants = constants;
+            ++rp;
+            const RpnProgram* word = words[rpnOperand(w)];
+            pc = code = word->instructions();
+            constants = word->constantPool();
+        }
+        RPN_NEXT;
+    RPN_CASE(FETCH)
+        *sp++ = variables[rpnOperand(w)];
+        RPN_NEXT;
+    RPN_CASE(STORE)
+        variables[rpnOperand(w)] = *--sp;
+        RPN_NEXT;
+    RPN_CASE(QUIT)
+        res = false;
+        goto finish;
+    RPN_CASE(END)
+        if (rp > rbase) {
+            --rp;               // Return from the word
+            pc = rp->pc;
+            code = rp->code;
+            constants = rp->constants;
+            RPN_NEXT;
+        }
+        goto finish;
+
+#ifndef RPN_THREADED_DISPATCH
+    }
+    }
+#endif
+#undef RPN_CASE
+#undef RPN_NEXT
+#undef RPN_PROFILE_STEP
+
+finish:
+    stack.resize((int)(sp - base));
+#ifdef RPN_PROFILE
+    if (stack.size() > profiler.profile.maxDepth)
+        profiler.profile.maxDepth = stack.size();
+    profiler.profile.programs = 1;
+    rpnProfileAdd(profiler.profile);
+#endif
+    return res;
+
+exhausted:
+    stack.resize((int)(sp - base));
+#ifdef RPN_PROFILE
+    profiler.profile.programs = 1;
+    rpnProfileAdd(profiler.profile);
+#endif
+    throw StackException("Too many jumps");
+}
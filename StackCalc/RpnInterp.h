@@ -0,0 +1,36 @@
+//
+// Interpreter of compiled programs of the stack calculator
+//
+#ifndef RPN_INTERP_H
+#define RPN_INTERP_H
+
+#include "RealStack.h"
+#include "RpnProgram.h"
+#include "RpnOutput.h"
+
+// Execute the program on the stack.
+// The depth of stack is checked once before execution (see
+// RpnProgram::canRun); the operations do not check it.
+// The fields $k of the current record are fields[k-1].
+// The commands "=" and "show" print to the output (by default,
+// to rpnStandardOutput). The words and variables are those of
+// the dictionary of program.
+// Throws StackException, if the stack is too small for the program
+// or there are less than program.columns() fields (then the stack
+// is not changed).
+// If maxJumps > 0, the program may jump back (repeat a loop) at most
+// maxJumps times; the next backward jump throws StackException
+// (the stack is left as it was at the jump).
+// Return value: false, if the program executed the command "quit"
+bool rpnExecute(
+    const RpnProgram& program, RealStack& stack,
+    const double* fields = 0, int numFields = 0,
+    RpnOutput* output = 0, long maxJumps = 0
+);
+
+// Limit of backward jumps of a program in the batch mode and
+// the server, where a program looping forever would block
+// the other ones
+const long RPN_MAX_JUMPS = 10000000;
+
+#endif
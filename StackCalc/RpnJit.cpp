@@ -0,0 +1,525 @@
+//
+// Translation of compiled programs of the stack calculator
+// to x86-64 machine code
+//
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include "RpnJit.h"
+
+#if defined(__x86_64__) && defined(__SSE2__)
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <emmintrin.h>
+#include "RpnMath.h"
+
+static const int opcodePops[RPN_NUM_OPCODES] = {
+#define RPN_OPCODE_POPS(name, pops, pushes) pops,
+    RPN_OPCODE_LIST(RPN_OPCODE_POPS)
+#undef RPN_OPCODE_POPS
+};
+
+static const int opcodePushes[RPN_NUM_OPCODES] = {
+#define RPN_OPCODE_PUSHES(name, pops, pushes) pushes,
+    RPN_OPCODE_LIST(RPN_OPCODE_PUSHES)
+#undef RPN_OPCODE_PUSHES
+};
+
+// Registers of the stack: xmm0 ... xmm(JIT_REGISTERS-1)
+const int JIT_REGISTERS = 15;
+const int JIT_SCRATCH = 15;         // xmm15
+
+// General registers
+enum {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R12 = 12, R13 = 13, R14 = 14,
+    RIP = (-1)              // Base of the constants
+};
+
+// The frame: 4 registers pushed and the area where the registers
+// of stack are saved around a call (16 bytes each), so that rsp is
+// aligned to 16 bytes at the calls
+const int JIT_FRAME_SIZE = JIT_REGISTERS * 16 + 8;
+
+// Prefixes of SSE2 instructions
+const int SSE_SD = 0xf2;            // Scalar double
+const int SSE_PD = 0x66;            // Packed double
+
+// Opcodes (after 0F)
+const int SSE_LOAD = 0x10;          // movsd, movupd
+const int SSE_STORE = 0x11;
+const int SSE_MOVAPD = 0x28;
+const int SSE_SQRT = 0x51;
+const int SSE_AND = 0x54;           // andpd
+const int SSE_ADD = 0x58;
+const int SSE_MUL = 0x59;
+const int SSE_SUB = 0x5c;
+const int SSE_DIV = 0x5e;
+const int SSE_CMP = 0xc2;
+
+// Predicates of cmpsd/cmppd
+const int CMP_EQ = 0;
+const int CMP_LT = 1;
+const int CMP_LE = 2;
+const int CMP_NE = 4;
+
+static __m128d pairFmod(__m128d x, __m128d y) {
+    double a[2], b[2];
+    _mm_storeu_pd(a, x);
+    _mm_storeu_pd(b, y);
+    return _mm_setr_pd(fmod(a[0], b[0]), fmod(a[1], b[1]));
+}
+
+// Address of the function of the opcode or 0
+static const void* function(int op, bool packed) {
+    typedef double (*Scalar1)(double);
+    typedef double (*Scalar2)(double, double);
+    typedef __m128d (*Packed1)(__m128d);
+    typedef __m128d (*Packed2)(__m128d, __m128d);
+    switch (op) {
+    case RPN_MOD:
+        return (packed? (const void*) pairFmod : (const void*)(Scalar2) fmod);
+    case RPN_POW:
+        return (packed?
+            (const void*)(Packed2) rpnPow : (const void*)(Scalar2) rpnPow);
+    case RPN_ATAN2:
+        return (packed?
+            (const void*)(Packed2) rpnAtan2 : (const void*)(Scalar2) rpnAtan2);
+    case RPN_SIN:
+        return (packed?
+            (const void*)(Packed1) rpnSin : (const void*)(Scalar1) rpnSin);
+    case RPN_COS:
+        return (packed?
+            (const void*)(Packed1) rpnCos : (const void*)(Scalar1) rpnCos);
+    case RPN_EXP:
+        return (packed?
+            (const void*)(Packed1) rpnExp : (const void*)(Scalar1) rpnExp);
+    case RPN_LOG:
+        return (packed?
+            (const void*)(Packed1) rpnLog : (const void*)(Scalar1) rpnLog);
+    }
+    return 0;
+}
+
+//
+// Machine code of the program. The constants are pairs of doubles
+// aligned to 16 bytes (for the packed instructions), which follow
+// the code; the displacements relative to rip are patched, when
+// the place of constants is known.
+//
+class RpnAssembler {
+public:
+    // Displacement to patch
+    class Fixup {
+    public:
+        size_t  position;       // Of the 32-bit displacement
+        int     constant;       // Index of pair of constants
+    };
+
+    std::vector<unsigned char> code;
+    std::vector<double> constants;      // Pairs
+    std::vector<Fixup> fixups;
+
+    RpnAssembler():
+        code(),
+        constants(),
+        fixups()
+    {}
+
+    void byte(int b) { code.push_back((unsigned char) b); }
+    void dword(uint32_t d) {
+        for (int i = 0; i < 4; ++i)
+            byte((int)(d >> (8 * i)) & 0xff);
+    }
+    void qword(uint64_t q) {
+        dword((uint32_t) q);
+        dword((uint32_t)(q >> 32));
+    }
+
+    int constant(double x) {
+        constants.push_back(x);
+        constants.push_back(x);
+        return (int) constants.size() / 2 - 1;
+    }
+
+    void rex(bool w, int reg, int index, int base) {
+        int r = (
+            0x40 | (w? 8 : 0) | ((reg & 8) >> 1) |
+            (index >= 0? (index & 8) >> 2 : 0) |
+            (base >= 0? (base & 8) >> 3 : 0)
+        );
+        if (r != 0x40)
+            byte(r);
+    }
+
+    // ModRM (and SIB, displacement) of the operand [base + index*8 + disp]
+    // or [rip + constant disp]
+    void address(int reg, int base, int index, int disp) {
+        if (base == RIP) {
+            byte(((reg & 7) << 3) | 5);
+            Fixup f;
+            f.position = code.size();
+            f.constant = disp;
+            fixups.push_back(f);
+            dword(0);
+        } else if (index >= 0 || (base & 7) == RSP) {
+            byte(0x80 | ((reg & 7) << 3) | 4);
+            if (index >= 0)
+                byte(0xc0 | ((index & 7) << 3) | (base & 7));
+            else
+                byte(0x20 | (base & 7));    // No index
+            dword((uint32_t) disp);
+        } else {
+            byte(0x80 | ((reg & 7) << 3) | (base & 7));
+            dword((uint32_t) disp);
+        }
+    }
+
+    // SSE2 instruction xmm, xmm
+    void sse(int prefix, int op, int dst, int src) {
+        if (prefix != 0)
+            byte(prefix);
+        rex(false, dst, -1, src);
+        byte(0x0f);
+        byte(op);
+        byte(0xc0 | ((dst & 7) << 3) | (src & 7));
+    }
+
+    // SSE2 instruction xmm, memory (or memory, xmm for stores)
+    void sse(int prefix, int op, int reg, int base, int index, int disp) {
+        if (prefix != 0)
+            byte(prefix);
+        rex(false, reg, index, (base == RIP? -1 : base));
+        byte(0x0f);
+        byte(op);
+        address(reg, base, index, disp);
+    }
+
+    // mov reg, [base + disp]
+    void load(int reg, int base, int disp) {
+        rex(true, reg, -1, base);
+        byte(0x8b);
+        address(reg, base, -1, disp);
+    }
+
+    // mov dst, src
+    void move(int dst, int src) {
+        rex(true, src, -1, dst);
+        byte(0x89);
+        byte(0xc0 | ((src & 7) << 3) | (dst & 7));
+    }
+
+    void push(int r) { rex(false, 0, -1, r); byte(0x50 | (r & 7)); }
+    void pop(int r) { rex(false, 0, -1, r); byte(0x58 | (r & 7)); }
+
+    // Call of the absolute address (by rax)
+    void call(const void* f) {
+        byte(0x48);
+        byte(0xb8);
+        qword((uint64_t)(uintptr_t) f);
+        byte(0xff);
+        byte(0xd0);
+    }
+
+    void prologue() {
+        push(RBX);
+        push(R12);
+        push(R13);
+        push(R14);
+        byte(0x48); byte(0x81); byte(0xec);     // sub rsp, imm32
+        dword(JIT_FRAME_SIZE);
+        move(RBX, RDI);
+        move(R12, RSI);
+        move(R13, RDX);
+    }
+
+    void epilogue() {
+        byte(0x48); byte(0x81); byte(0xc4);     // add rsp, imm32
+        dword(JIT_FRAME_SIZE);
+        pop(R14);
+        pop(R13);
+        pop(R12);
+        pop(RBX);
+        byte(0xc3);
+    }
+
+    // Size of code with the padding before the constants
+    size_t codeSize() const { return (code.size() + 15) & ~(size_t) 15; }
+
+    // The displacements of constants placed after the code
+    void link() {
+        size_t base = codeSize();
+        for (size_t i = 0; i < fixups.size(); ++i) {
+            size_t p = fixups[i].position;
+            int64_t d = (int64_t)(base + 16 * fixups[i].constant) -
+                (int64_t)(p + 4);
+            for (int k = 0; k < 4; ++k)
+                code[p + k] = (unsigned char)((uint64_t) d >> (8 * k));
+        }
+    }
+
+    bool translate(const RpnProgram& program, bool packed, int one);
+
+private:
+    RpnAssembler(const RpnAssembler&);              // Not implemented
+    RpnAssembler& operator=(const RpnAssembler&);   // Not implemented
+};
+
+// Can the program be translated?
+static bool translatable(const RpnProgram& program) {
+    if (!program.simple() || !program.canRun(0))
+        return false;
+    const RpnInstruction* code = program.instructions();
+    int d = 0;
+    for (int i = 0; i < program.size(); ++i) {
+        int op = rpnOpcode(code[i]);
+        switch (op) {
+        case RPN_DISPLAY:
+        case RPN_SHOW:
+        case RPN_STATS:
+        case RPN_QUIT:
+        case RPN_FETCH:
+            return false;
+        case RPN_CLEAR:
+            d = 0;
+            break;
+        case RPN_END:
+            return (d > 0);
+        default:
+            break;
+        }
+        d += opcodePushes[op] - opcodePops[op];
+        if (d > JIT_REGISTERS)
+            return false;
+    }
+    return false;
+}
+
+//
+// The body of the scalar function: double f(const double* fields),
+// with fields in rbx; or of the array function: void f(columns, n,
+// result) with columns in rbx, n in r12, result in r13, where r14
+// is the index of record (the loop by pairs of records).
+//
+bool RpnAssembler::translate(
+    const RpnProgram& program, bool packed, int one
+) {
+    int prefix = (packed? SSE_PD : SSE_SD);
+    const RpnInstruction* code = program.instructions();
+    const double* pool = program.constantPool();
+    size_t loop = 0, exitJump = 0;
+
+    prologue();
+    if (packed) {
+        byte(0x4d); byte(0x31); byte(0xf6);     // xor r14, r14
+        loop = this->code.size();
+        byte(0x4d); byte(0x39); byte(0xe6);     // cmp r14, r12
+        byte(0x0f); byte(0x8d);                 // jge exit
+        exitJump = this->code.size();
+        dword(0);
+    }
+
+    int d = 0;      // Depth of stack: the top is xmm(d-1)
+    for (int i = 0; i < program.size(); ++i) {
+        RpnInstruction w = code[i];
+        int op = rpnOpcode(w);
+        int a = d - 2, b = d - 1;
+        switch (op) {
+        case RPN_PUSH:
+            if (packed) {
+                sse(SSE_PD, SSE_MOVAPD, d, RIP, -1,
+                    constant(pool[rpnOperand(w)]));
+            } else {
+                sse(SSE_SD, SSE_LOAD, d, RIP, -1,
+                    constant(pool[rpnOperand(w)]));
+            }
+            break;
+        case RPN_COLUMN:
+            if (packed) {
+                load(RAX, RBX, 8 * rpnOperand(w));
+                sse(SSE_PD, SSE_LOAD, d, RAX, R14, 0);
+            } else {
+                sse(SSE_SD, SSE_LOAD, d, RBX, -1, 8 * rpnOperand(w));
+            }
+            break;
+        case RPN_ADD: sse(prefix, SSE_ADD, a, b); break;
+        case RPN_SUB: sse(prefix, SSE_SUB, a, b); break;
+        case RPN_MUL: sse(prefix, SSE_MUL, a, b); break;
+        case RPN_DIV: sse(prefix, SSE_DIV, a, b); break;
+        case RPN_PUSH_ADD:
+        case RPN_PUSH_SUB:
+        case RPN_PUSH_MUL:
+        case RPN_PUSH_DIV:
+            {
+                static const int ops[] = {
+                    SSE_ADD, SSE_SUB, SSE_MUL, SSE_DIV
+                };
+                sse(prefix, ops[op - RPN_PUSH_ADD], b, RIP, -1,
+                    constant(pool[rpnOperand(w)]));
+            }
+            break;
+        case RPN_SQRT:
+            sse(prefix, SSE_SQRT, b, b);
+            break;
+        case RPN_LT:
+        case RPN_LE:
+        case RPN_EQ:
+        case RPN_NE:
+            sse(prefix, SSE_CMP, a, b);
+            byte(op == RPN_LT? CMP_LT : op == RPN_LE? CMP_LE :
+                op == RPN_EQ? CMP_EQ : CMP_NE);
+            sse(SSE_PD, SSE_AND, a, RIP, -1, one);
+            break;
+        case RPN_GT:
+        case RPN_GE:
+            // a > b is b < a (false for NaN)
+            sse(SSE_PD, SSE_MOVAPD, JIT_SCRATCH, b);
+            sse(prefix, SSE_CMP, JIT_SCRATCH, a);
+            byte(op == RPN_GT? CMP_LT : CMP_LE);
+            sse(SSE_PD, SSE_AND, JIT_SCRATCH, RIP, -1, one);
+            sse(SSE_PD, SSE_MOVAPD, a, JIT_SCRATCH);
+            break;
+        case RPN_MOD:
+        case RPN_POW:
+        case RPN_ATAN2:
+        case RPN_SIN:
+        case RPN_COS:
+        case RPN_EXP:
+        case RPN_LOG:
+            {
+                int args = opcodePops[op];
+                int live = d - args;    // Registers below the arguments
+                for (int r = 0; r < live; ++r)
+                    sse(SSE_PD, SSE_STORE, r, RSP, -1, 16 * r);
+                if (args == 2) {
+                    if (a != 0)
+                        sse(SSE_PD, SSE_MOVAPD, 0, a);
+                    if (b != 1)
+                        sse(SSE_PD, SSE_MOVAPD, 1, b);
+                } else if (b != 0) {
+                    sse(SSE_PD, SSE_MOVAPD, 0, b);
+                }
+                call(function(op, packed));
+                if (live != 0)
+                    sse(SSE_PD, SSE_MOVAPD, live, 0);
+                for (int r = 0; r < live; ++r)
+                    sse(SSE_PD, SSE_LOAD, r, RSP, -1, 16 * r);
+            }
+            break;
+        case RPN_POP:
+            break;
+        case RPN_DUP:
+            sse(SSE_PD, SSE_MOVAPD, d, b);
+            break;
+        case RPN_EXCH:
+            sse(SSE_PD, SSE_MOVAPD, JIT_SCRATCH, b);
+            sse(SSE_PD, SSE_MOVAPD, b, a);
+            sse(SSE_PD, SSE_MOVAPD, a, JIT_SCRATCH);
+            break;
+        case RPN_CLEAR:
+            d = 0;
+            break;
+        case RPN_END:
+            if (packed) {
+                sse(SSE_PD, SSE_STORE, b, R13, R14, 0);
+                byte(0x49); byte(0x83); byte(0xc6); byte(2);  // add r14, 2
+                byte(0xe9);                                     // jmp loop
+                dword((uint32_t)(
+                    (int64_t) loop - (int64_t)(this->code.size() + 4)
+                ));
+                uint32_t e = (uint32_t)(this->code.size() - (exitJump + 4));
+                for (int k = 0; k < 4; ++k)
+                    this->code[exitJump + k] = (unsigned char)(e >> (8 * k));
+            } else if (b != 0) {
+                sse(SSE_PD, SSE_MOVAPD, 0, b);
+            }
+            epilogue();
+            return true;
+        default:
+            return false;       // Not translatable
+        }
+        d += opcodePushes[op] - opcodePops[op];
+    }
+    return false;
+}
+
+bool RpnJitCode::compile(const RpnProgram& program) {
+    clear();
+    if (!translatable(program))
+        return false;
+
+    RpnAssembler as;
+    int one = as.constant(1.);
+    size_t arrayStart = 0;
+    if (!as.translate(program, false, one))
+        return false;
+    while (as.code.size() % 16 != 0)
+        as.byte(0xcc);                  // int3
+    arrayStart = as.code.size();
+    if (!as.translate(program, true, one))
+        return false;
+    as.link();
+
+    size_t codeSize = as.codeSize();
+    size_t total = codeSize + as.constants.size() * sizeof(double);
+    long page = sysconf(_SC_PAGESIZE);
+    size_t mapped = (total + page - 1) / page * page;
+    void* m = mmap(
+        0, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+    );
+    if (m == MAP_FAILED)
+        return false;
+    unsigned char* p = (unsigned char*) m;
+    memcpy(p, &(as.code[0]), as.code.size());
+    memset(p + as.code.size(), 0xcc, codeSize - as.code.size());
+    memcpy(
+        p + codeSize, &(as.constants[0]),
+        as.constants.size() * sizeof(double)
+    );
+    if (mprotect(m, mapped, PROT_READ | PROT_EXEC) != 0) {
+        munmap(m, mapped);
+        return false;
+    }
+    memory = p;
+    size = mapped;
+    scalarCode = (ScalarFunction) (void*) p;
+    arrayCode = (ArrayFunction) (void*) (p + arrayStart);
+    numColumns = program.columns();
+    return true;
+}
+
+void RpnJitCode::clear() {
+    if (memory != 0)
+        munmap(memory, size);
+    memory = 0;
+    size = 0;
+    scalarCode = 0;
+    arrayCode = 0;
+    numColumns = 0;
+}
+
+#else   // Not x86-64
+
+bool RpnJitCode::compile(const RpnProgram&) {
+    return false;
+}
+
+void RpnJitCode::clear() {}
+
+#endif
+
+void RpnJitCode::evaluate(
+    const double* const* columns, int n, double* result
+) const {
+    int pairs = n & ~1;
+    if (pairs > 0)
+        arrayCode(columns, pairs, result);
+    if (pairs < n) {
+        std::vector<double> fields(numColumns > 0? numColumns : 1);
+        for (int k = 0; k < numColumns; ++k)
+            fields[k] = columns[k][pairs];
+        result[pairs] = scalarCode(&(fields[0]));
+    }
+}
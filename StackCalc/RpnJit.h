@@ -0,0 +1,81 @@
+//
+// Translation of compiled programs of the stack calculator
+// to x86-64 machine code
+//
+#ifndef RPN_JIT_H
+#define RPN_JIT_H
+
+#include <stddef.h>
+#include "RpnProgram.h"
+
+//
+// The stack of program is kept in the SSE2 registers xmm0 ... xmm14
+// (xmm15 is a scratch register): as the program has no jumps, the
+// depth of stack is known at every instruction, so every element
+// of stack is a fixed register, and the stack operations (dup, exch,
+// pop) only rename or copy registers. The constants are placed after
+// the code and addressed relative to the instruction pointer.
+// The functions (see "RpnMath.h") and % are called with the live
+// registers saved in the native stack frame.
+//
+// Two functions are made from the program: for a record (scalar SSE2
+// instructions) and for columns, where every register holds the
+// values of two records (packed instructions, the functions of pairs
+// of "RpnMath.h"), so the results are the same bits as those of the
+// interpreter. The code is written to pages mapped by mmap() and then
+// made executable (and not writable).
+//
+// Only the programs that can be computed by columns are translated
+// (see RpnProgram::simple): without variables, "=", "show", "stats",
+// "quit", beginning with the empty stack, with at most 15 elements
+// and not empty at the end. Other programs (and any program out of
+// x86-64) are not translated, and the caller uses the interpreter
+// or RpnColumnEvaluator instead, which also reports the errors.
+//
+class RpnJitCode {
+public:
+    typedef double (*ScalarFunction)(const double* fields);
+    typedef void (*ArrayFunction)(
+        const double* const* columns, long n, double* result
+    );
+
+private:
+    unsigned char*  memory;         // Mapped pages
+    size_t          size;
+    ScalarFunction  scalarCode;
+    ArrayFunction   arrayCode;      // For an even number of records
+    int             numColumns;
+
+public:
+    RpnJitCode():
+        memory(0),
+        size(0),
+        scalarCode(0),
+        arrayCode(0),
+        numColumns(0)
+    {}
+
+    ~RpnJitCode() { clear(); }
+
+    // Translate the program.
+    // Return value: false, if the program cannot be translated
+    bool compile(const RpnProgram& program);
+
+    bool compiled() const { return (scalarCode != 0); }
+    void clear();
+
+    // Result of the program for the record with the fields $k
+    // equal to fields[k-1]
+    double evaluate(const double* fields) const {
+        return scalarCode(fields);
+    }
+
+    // Compute the program for n records, as RpnColumnEvaluator
+    void evaluate(const double* const* columns, int n, double* result) const;
+
+private:
+    RpnJitCode(const RpnJitCode&);              // Not implemented
+    RpnJitCode& operator=(const RpnJitCode&);   // Not implemented
+};
+
+#endif
@@ -0,0 +1,673 @@
+//
+// Mathematical functions of the stack calculator
+//
+// The functions are templates over a class of operations on the type
+// Real: ScalarMath for double and SseMath for __m128d (two numbers).
+// There are no branches on the values: both alternatives are computed
+// and one of them is selected by a mask. The arguments, which are
+// not reduced, are passed to libm at the end ("fallback").
+//
+// The polynomials are the Taylor series, except atan (Chebyshev
+// interpolation, see atan2); exp and log take the most of result from
+// a table, so that their polynomials are short. The constants split
+// in two doubles (HI + LO) keep the products k * HI exact.
+//
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "RpnMath.h"
+
+typedef double (*RpnFunction)(double);
+typedef double (*RpnFunction2)(double, double);
+
+// Adding and subtracting 1.5 * 2^52 rounds a number to an integer;
+// then the integer is in the lower bits of the sum
+static const double ROUND_MAGIC = 0x1.8p52;
+static const uint64_t ROUND_MAGIC_BITS = 0x4338000000000000ULL;
+static const uint64_t MANTISSA_BITS = 0x000fffffffffffffULL;
+static const uint64_t ONE_BITS = 0x3ff0000000000000ULL;
+
+class ScalarMath {
+public:
+    typedef double Real;
+    typedef bool Mask;
+
+    static Real constant(double c) { return c; }
+    static Real select(Mask m, Real a, Real b) { return (m? a : b); }
+    static Mask less(Real a, Real b) { return a < b; }
+    static Mask lessEqual(Real a, Real b) { return a <= b; }
+    static Mask equal(Real a, Real b) { return a == b; }
+    static Mask isNan(Real a) { return a != a; }
+    static Mask both(Mask a, Mask b) { return a && b; }
+    static Mask either(Mask a, Mask b) { return a || b; }
+    static Mask invert(Mask a) { return !a; }
+    static Real min(Real a, Real b) { return (a < b? a : b); }
+    static Real max(Real a, Real b) { return (a > b? a : b); }
+    static Real abs(Real x) { return fabs(x); }
+    static Real sqrt(Real x) { return ::sqrt(x); }
+    static Real copySign(Real x, Real s) { return copysign(x, s); }
+
+    // 2^k for an integer k, -1022 <= k <= 1023
+    static Real pow2(Real k) {
+        uint64_t b = bits(k + ROUND_MAGIC) - ROUND_MAGIC_BITS + 1023;
+        return fromBits(b << 52);
+    }
+
+    // x = mantissa * 2^exponent for a positive normal x;
+    // 1 <= mantissa < 2
+    static Real exponent(Real x) {
+        return fromBits((bits(x) >> 52) | 0x4330000000000000ULL) -
+            (0x1p52 + 1023);
+    }
+    static Real mantissa(Real x) {
+        return fromBits((bits(x) & MANTISSA_BITS) | ONE_BITS);
+    }
+
+    // table[i] for an integer i
+    static Real lookup(const double* table, Real i) {
+        return table[(int) i];
+    }
+
+    static Real fallback(Mask m, Real r, Real x, RpnFunction f) {
+        return (m? f(x) : r);
+    }
+    static Real fallback(Mask m, Real r, Real x, Real y, RpnFunction2 f) {
+        return (m? f(x, y) : r);
+    }
+
+private:
+    static uint64_t bits(double x) {
+        uint64_t b;
+        memcpy(&b, &x, sizeof(b));
+        return b;
+    }
+    static double fromBits(uint64_t b) {
+        double x;
+        memcpy(&x, &b, sizeof(x));
+        return x;
+    }
+};
+
+#ifdef __SSE2__
+class SseMath {
+public:
+    typedef __m128d Real;
+    typedef __m128d Mask;
+
+    static Real constant(double c) { return _mm_set1_pd(c); }
+    static Real select(Mask m, Real a, Real b) {
+        return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+    }
+    static Mask less(Real a, Real b) { return _mm_cmplt_pd(a, b); }
+    static Mask lessEqual(Real a, Real b) { return _mm_cmple_pd(a, b); }
+    static Mask equal(Real a, Real b) { return _mm_cmpeq_pd(a, b); }
+    static Mask isNan(Real a) { return _mm_cmpunord_pd(a, a); }
+    static Mask both(Mask a, Mask b) { return _mm_and_pd(a, b); }
+    static Mask either(Mask a, Mask b) { return _mm_or_pd(a, b); }
+    static Mask invert(Mask a) {
+        return _mm_xor_pd(a, _mm_castsi128_pd(_mm_set1_epi32(-1)));
+    }
+    static Real min(Real a, Real b) { return _mm_min_pd(a, b); }
+    static Real max(Real a, Real b) { return _mm_max_pd(a, b); }
+    static Real abs(Real x) { return _mm_andnot_pd(_mm_set1_pd(-0.), x); }
+    static Real sqrt(Real x) { return _mm_sqrt_pd(x); }
+    static Real copySign(Real x, Real s) {
+        __m128d sign = _mm_set1_pd(-0.);
+        return _mm_or_pd(_mm_andnot_pd(sign, x), _mm_and_pd(sign, s));
+    }
+
+    static Real pow2(Real k) {
+        __m128i b =
+            _mm_castpd_si128(_mm_add_pd(k, _mm_set1_pd(ROUND_MAGIC)));
+        b = _mm_add_epi64(
+            b, _mm_set1_epi64x(1023 - (int64_t) ROUND_MAGIC_BITS)
+        );
+        return _mm_castsi128_pd(_mm_slli_epi64(b, 52));
+    }
+
+    static Real exponent(Real x) {
+        __m128i e = _mm_srli_epi64(_mm_castpd_si128(x), 52);
+        e = _mm_or_si128(e, _mm_set1_epi64x(0x4330000000000000LL));
+        return _mm_sub_pd(_mm_castsi128_pd(e), _mm_set1_pd(0x1p52 + 1023));
+    }
+    static Real mantissa(Real x) {
+        __m128i m = _mm_and_si128(
+            _mm_castpd_si128(x), _mm_set1_epi64x((int64_t) MANTISSA_BITS)
+        );
+        m = _mm_or_si128(m, _mm_set1_epi64x((int64_t) ONE_BITS));
+        return _mm_castsi128_pd(m);
+    }
+
+    static Real lookup(const double* table, Real i) {
+        __m128i k = _mm_cvttpd_epi32(i);
+        return _mm_setr_pd(
+            table[_mm_cvtsi128_si32(k)],
+            table[_mm_cvtsi128_si32(_mm_shuffle_epi32(k, 1))]
+        );
+    }
+
+    static Real fallback(Mask m, Real r, Real x, RpnFunction f) {
+        int lanes = _mm_movemask_pd(m);
+        if (lanes == 0)
+            return r;
+        double res[2], a[2];
+        _mm_storeu_pd(res, r);
+        _mm_storeu_pd(a, x);
+        for (int i = 0; i < 2; ++i) {
+            if (lanes & (1 << i))
+                res[i] = f(a[i]);
+        }
+        return _mm_loadu_pd(res);
+    }
+    static Real fallback(Mask m, Real r, Real x, Real y, RpnFunction2 f) {
+        int lanes = _mm_movemask_pd(m);
+        if (lanes == 0)
+            return r;
+        double res[2], a[2], b[2];
+        _mm_storeu_pd(res, r);
+        _mm_storeu_pd(a, x);
+        _mm_storeu_pd(b, y);
+        for (int i = 0; i < 2; ++i) {
+            if (lanes & (1 << i))
+                res[i] = f(a[i], b[i]);
+        }
+        return _mm_loadu_pd(res);
+    }
+};
+#endif
+
+// c[First] + c[First+1] x + ... + c[N-1] x^(N-1-First) by four
+// Horner chains in x^4 (for the parallel execution of the chains):
+// p = p0(x^4) + x p1(x^4) + x^2 p2(x^4) + x^3 p3(x^4)
+template <class M, int First, int N>
+static inline typename M::Real polynomial(
+    typename M::Real x, const double (&c)[N]
+) {
+    typedef typename M::Real Real;
+    const int n = N - First;
+    const int top = (n - 1) & ~3;       // The last group of 4
+    Real x2 = x * x;
+    Real x4 = x2 * x2;
+    Real p[4];
+    for (int j = 0; j < 4; ++j)
+        p[j] = M::constant(top + j < n? c[First + top + j] : 0.);
+    for (int i = top - 4; i >= 0; i -= 4) {
+        for (int j = 0; j < 4; ++j)
+            p[j] = p[j] * x4 + M::constant(c[First + i + j]);
+    }
+    return (p[0] + x * p[1]) + x2 * (p[2] + x * p[3]);
+}
+
+template <class M>
+static inline typename M::Real roundToInteger(typename M::Real x) {
+    typename M::Real magic = M::constant(ROUND_MAGIC);
+    return (x + magic) - magic;
+}
+
+// x * 2^k for an integer k, -2044 <= k <= 2046: by two factors,
+// so that a subnormal result is rounded once
+template <class M>
+static inline typename M::Real scale(
+    typename M::Real x, typename M::Real k
+) {
+    typename M::Real k1 = roundToInteger<M>(k * M::constant(0.5));
+    return x * M::pow2(k1) * M::pow2(k - k1);
+}
+
+//
+// Sums and products of two doubles without rounding: a + b = s + e,
+// a * b = p + e (Dekker's algorithm, as there is no fused multiply-add
+// in SSE2)
+//
+
+template <class M>
+static inline void twoSum(
+    typename M::Real a, typename M::Real b,
+    typename M::Real& s, typename M::Real& e
+) {
+    s = a + b;
+    typename M::Real bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+}
+
+// |a| >= |b|
+template <class M>
+static inline void fastTwoSum(
+    typename M::Real a, typename M::Real b,
+    typename M::Real& s, typename M::Real& e
+) {
+    s = a + b;
+    e = b - (s - a);
+}
+
+template <class M>
+static inline void split(
+    typename M::Real a, typename M::Real& hi, typename M::Real& lo
+) {
+    typename M::Real c = M::constant(0x1p27 + 1) * a;
+    hi = c - (c - a);
+    lo = a - hi;
+}
+
+// |a|, |b| < 2^995
+template <class M>
+static inline void twoProduct(
+    typename M::Real a, typename M::Real b,
+    typename M::Real& p, typename M::Real& e
+) {
+    typename M::Real ah, al, bh, bl;
+    split<M>(a, ah, al);
+    split<M>(b, bh, bl);
+    p = a * b;
+    e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+//
+// exp(x) = 2^(k/N) * exp(r), where k = round(x N / ln 2), N = 128,
+// |r| <= ln(2) / 2N; 2^(k/N) = 2^(k div N) * 2^(j/N), j = k mod N,
+// where 2^(j/N) is taken from the table as the sum of two doubles,
+// and exp(r) = 1 + r + r^2/2! + ... + r^5/5! (the next term is below
+// 2^-60). The arguments are limited to [-746, 710], where the result
+// is already 0 or infinity.
+//
+// log(x) = e ln 2 + log(c) + log(1 + r), x = m * 2^e,
+// sqrt(1/2) <= m < sqrt(2), where c = i/N is the nearest to m,
+// r = (m - c) / c, |r| < 1/(sqrt(2) N), and log(c) is taken from
+// the table as the sum of two doubles. r is computed exactly as the
+// sum rh + rl of two doubles, and log(1 + r) = r - r^2/2 + ... - r^8/8
+// (the next term is below 2^-62 of r). The sum is computed as two
+// doubles hi + lo with the error about 2^-70 of the result, for pow;
+// the log is hi.
+//
+// The tables are computed at start with long double (the values
+// of exp2l and logl are exact to about 2^-63).
+//
+
+const int TABLE_BITS = 7;
+const int TABLE_SIZE = 1 << TABLE_BITS;         // N
+const int LOG_TABLE_FIRST = 91;                 // i of sqrt(1/2) N
+const int LOG_TABLE_SIZE = 182 - LOG_TABLE_FIRST;
+
+class RpnMathTables {
+public:
+    double exp2Hi[TABLE_SIZE];      // 2^(j/N)
+    double exp2Lo[TABLE_SIZE];
+    double logInverse[LOG_TABLE_SIZE];  // About N/i
+    double logHi[LOG_TABLE_SIZE];       // log(i/N)
+    double logLo[LOG_TABLE_SIZE];
+
+    RpnMathTables() {
+        for (int j = 0; j < TABLE_SIZE; ++j) {
+            long double v = exp2l((long double) j / TABLE_SIZE);
+            exp2Hi[j] = (double) v;
+            exp2Lo[j] = (double) (v - exp2Hi[j]);
+        }
+        for (int k = 0; k < LOG_TABLE_SIZE; ++k) {
+            int i = LOG_TABLE_FIRST + k;
+            long double v = logl((long double) i / TABLE_SIZE);
+            logInverse[k] = (double) TABLE_SIZE / i;
+            logHi[k] = (double) v;
+            logLo[k] = (double) (v - logHi[k]);
+        }
+    }
+};
+
+static const RpnMathTables tables;
+
+static const double LN2_HI = 0x1.62e42ffp-1;    // 29 bits
+static const double LN2_LO = -0x1.718432a1b0e26p-35;
+static const double INV_LN2 = 0x1.71547652b82fep+0;
+
+static const double EXP_COEFFICIENTS[] = {
+    1. / 2, 1. / 6, 1. / 24, 1. / 120
+};
+
+// 2^(k/N) * exp(r)
+template <class M>
+static inline typename M::Real expReduced(
+    typename M::Real r, typename M::Real k
+) {
+    typedef typename M::Real Real;
+    Real kTop = roundToInteger<M>(
+        (k - M::constant(TABLE_SIZE / 2 - 0.5)) *
+        M::constant(1. / TABLE_SIZE)
+    );
+    Real j = k - kTop * M::constant(TABLE_SIZE);
+    Real t = M::lookup(tables.exp2Hi, j);
+    Real tl = M::lookup(tables.exp2Lo, j);
+    Real p = r + r * r * polynomial<M, 0>(r, EXP_COEFFICIENTS);
+    return scale<M>(t + (tl + t * p), kTop);
+}
+
+template <class M>
+static typename M::Real exponential(typename M::Real x) {
+    typedef typename M::Real Real;
+    Real xc = M::max(M::min(x, M::constant(710.)), M::constant(-746.));
+    Real k = roundToInteger<M>(xc * M::constant(INV_LN2 * TABLE_SIZE));
+    Real r = (xc - k * M::constant(LN2_HI / TABLE_SIZE)) -
+        k * M::constant(LN2_LO / TABLE_SIZE);
+    Real res = expReduced<M>(r, k);
+    return M::select(M::isNan(x), x, res);
+}
+
+static const double LOG_COEFFICIENTS[] = {
+    -1. / 2, 1. / 3, -1. / 4, 1. / 5, -1. / 6, 1. / 7, -1. / 8
+};
+
+static const double SQRT2 = 0x1.6a09e667f3bcdp+0;
+
+// x = m * 2^e for a positive finite x
+template <class M>
+static inline void decompose(
+    typename M::Real x, typename M::Real& m, typename M::Real& e
+) {
+    typename M::Mask subnormal = M::less(x, M::constant(0x1p-1022));
+    x = M::select(subnormal, x * M::constant(0x1p54), x);
+    e = M::exponent(x) -
+        M::select(subnormal, M::constant(54.), M::constant(0.));
+    m = M::mantissa(x);
+    typename M::Mask big = M::less(M::constant(SQRT2), m);
+    m = M::select(big, m * M::constant(0.5), m);
+    e = M::select(big, e + M::constant(1.), e);
+}
+
+// log(x) = hi + lo for a positive finite x
+template <class M>
+static inline void logarithm2(
+    typename M::Real x, typename M::Real& hi, typename M::Real& lo
+) {
+    typedef typename M::Real Real;
+    Real m, e;
+    decompose<M>(x, m, e);
+    Real i = roundToInteger<M>(m * M::constant(TABLE_SIZE));
+    Real c = i * M::constant(1. / TABLE_SIZE);          // 8 bits
+    Real k = i - M::constant(LOG_TABLE_FIRST);
+    Real d = m - c;                                     // Exact
+    Real inverse = M::lookup(tables.logInverse, k);
+    // r = d / c = rh + rl: the remainder d - rh c is exact,
+    // as the parts of rh have 26 bits
+    Real rh = d * inverse;
+    Real a, b;
+    split<M>(rh, a, b);
+    Real rl = ((d - a * c) - b * c) * inverse;
+    Real q = rh * rh * polynomial<M, 0>(rh, LOG_COEFFICIENTS);
+    // e ln 2 + log(c) + rh + (rl + q); |e ln 2 + log(c)| >= |rh|,
+    // unless it is 0
+    Real s, se;
+    twoSum<M>(e * M::constant(LN2_HI), M::lookup(tables.logHi, k), s, se);
+    Real t;
+    fastTwoSum<M>(s, rh, hi, t);
+    lo = t + (se + (rl + q + e * M::constant(LN2_LO) +
+        M::lookup(tables.logLo, k)));
+    fastTwoSum<M>(hi, lo, hi, lo);
+}
+
+template <class M>
+static typename M::Real logarithm(typename M::Real x) {
+    typedef typename M::Real Real;
+    Real zero = M::constant(0.), inf = M::constant(INFINITY);
+    Real hi, lo;
+    logarithm2<M>(
+        M::select(M::lessEqual(x, zero), M::constant(1.), x), hi, lo
+    );
+    Real res = M::select(M::equal(x, zero), M::constant(-INFINITY), hi);
+    res = M::select(M::less(x, zero), M::constant(NAN), res);
+    res = M::select(M::equal(x, inf), inf, res);
+    return M::select(M::isNan(x), x, res);
+}
+
+//
+// sin and cos: x = k * pi/2 + r, |r| <= pi/4, where pi/2 is split
+// in 4 parts (3 of 33 bits), so that the products by k < 2^20
+// are exact, and r = rh + rl is the sum of two doubles. The Taylor
+// series of sin(r) and cos(r) up to r^17 and r^16; the quadrant
+// k mod 4 selects one of them and the sign. For |x| >= 2^20,
+// infinity and NaN, libm is called.
+//
+
+static const double PIO2_1 = 0x1.921fb544p+0;
+static const double PIO2_2 = 0x1.0b4611a6p-34;
+static const double PIO2_3 = 0x1.3198a2ep-69;
+static const double PIO2_3T = 0x1.b839a252049c1p-104;
+static const double TWO_OVER_PI = 0x1.45f306dc9c883p-1;
+static const double SIN_COS_LIMIT = 0x1p20;
+
+static const double SIN_COEFFICIENTS[] = {
+    -1. / 6, 1. / 120, -1. / 5040, 1. / 362880, -1. / 39916800,
+    1. / 6227020800., -1. / 1307674368000., 1. / 355687428096000.
+};
+
+static const double COS_COEFFICIENTS[] = {
+    1. / 24, -1. / 720, 1. / 40320, -1. / 3628800, 1. / 479001600,
+    -1. / 87178291200., 1. / 20922789888000.
+};
+
+template <class M>
+static typename M::Real sinCos(typename M::Real x, bool cosine) {
+    typedef typename M::Real Real;
+    typedef typename M::Mask Mask;
+    Real k = roundToInteger<M>(x * M::constant(TWO_OVER_PI));
+    Real rh, rl;
+    twoSum<M>(x - k * M::constant(PIO2_1), -(k * M::constant(PIO2_2)), rh, rl);
+    rl = rl - (k * M::constant(PIO2_3) + k * M::constant(PIO2_3T));
+    twoSum<M>(rh, rl, rh, rl);
+
+    // sin(r) = rh + rh z S(z) + rl (1 - z/2), z = rh^2
+    Real z = rh * rh;
+    Real hz = M::constant(0.5) * z;
+    Real one = M::constant(1.);
+    Real s = rh + (rh * z * polynomial<M, 0>(z, SIN_COEFFICIENTS) +
+        rl * (one - hz));
+    // cos(r) = 1 - z/2 + z^2 C(z) - rh rl: w = 1 - z/2 and its error
+    Real w = one - hz;
+    Real c = w + (((one - w) - hz) +
+        (z * z * polynomial<M, 0>(z, COS_COEFFICIENTS) - rh * rl));
+
+    // The quadrant q = k mod 4
+    Real q = k - M::constant(4.) *
+        roundToInteger<M>(k * M::constant(0.25) - M::constant(0.375));
+    Mask odd = M::either(
+        M::equal(q, M::constant(1.)), M::equal(q, M::constant(3.))
+    );
+    Real res;
+    Mask negative;
+    if (cosine) {
+        res = M::select(odd, s, c);
+        negative = M::either(
+            M::equal(q, M::constant(1.)), M::equal(q, M::constant(2.))
+        );
+    } else {
+        res = M::select(odd, c, s);
+        negative = M::less(M::constant(1.5), q);
+    }
+    res = M::select(negative, -res, res);
+    if (!cosine)    // sin(-0) = -0
+        res = M::select(M::equal(x, M::constant(0.)), x, res);
+    Mask large = M::invert(M::less(M::abs(x), M::constant(SIN_COS_LIMIT)));
+    return M::fallback(
+        large, res, x, (cosine? (RpnFunction) cos : (RpnFunction) sin)
+    );
+}
+
+//
+// pow(x, y) = exp(y * log(x)) for 0 < x < infinity, |y| < 2^60;
+// log(x) and y * log(x) are computed as sums of two doubles, since
+// an error e of y * log(x) is the relative error e of the result.
+// Other arguments are passed to libm (negative x, zeros, infinities
+// and NaN).
+//
+
+static const double POW_Y_LIMIT = 0x1p60;
+
+template <class M>
+static typename M::Real power(typename M::Real x, typename M::Real y) {
+    typedef typename M::Real Real;
+    typedef typename M::Mask Mask;
+    Real zero = M::constant(0.);
+    Mask reduced = M::both(
+        M::both(M::less(zero, x), M::less(x, M::constant(INFINITY))),
+        M::less(M::abs(y), M::constant(POW_Y_LIMIT))
+    );
+    Real xr = M::select(reduced, x, M::constant(1.));
+    Real yr = M::select(reduced, y, zero);
+
+    Real lh, ll;
+    logarithm2<M>(xr, lh, ll);
+    Real ph, pl;
+    twoProduct<M>(yr, lh, ph, pl);
+    pl = pl + yr * ll;
+    ph = M::max(M::min(ph, M::constant(710.)), M::constant(-746.));
+    Real k = roundToInteger<M>(ph * M::constant(INV_LN2 * TABLE_SIZE));
+    Real r = ((ph - k * M::constant(LN2_HI / TABLE_SIZE)) + pl) -
+        k * M::constant(LN2_LO / TABLE_SIZE);
+    Real res = expReduced<M>(r, k);
+    return M::fallback(M::invert(reduced), res, x, y, pow);
+}
+
+//
+// atan2(y, x): t = min(|x|, |y|) / max(|x|, |y|) <= 1 and
+// atan(t) = atan(c) + atan((t - c) / (1 + c t)), where c is 0, 1/2
+// or 1 for t in [0, 7/16], [7/16, 11/16] or [11/16, 1], so that
+// the argument u of atan is at most 7/16. There atan(u) is
+// u + u^3 g(u^2), where the polynomial g of degree 10 interpolates
+// (atan(sqrt(z)) - sqrt(z)) / z^(3/2) at the Chebyshev nodes
+// of [0, (7/16)^2] (the error is below 2^-62 of the result).
+// Then the quadrant gives pi/2 - a, pi - a and the sign of y.
+// t, u and a are sums of two doubles. The zeros, infinities
+// and NaN are passed to libm.
+//
+
+static const double ATAN_COEFFICIENTS[] = {
+    -0.33333333333333326, 0.1999999999998777, -0.1428571428314864,
+    0.11111110900560475, -0.09090900195560148, 0.07692087348767168,
+    -0.06663239299107136, 0.05847724720645106, -0.05033942776485848,
+    0.03782521866106712, -0.017547235157290002
+};
+
+static const double ATAN_HALF_HI = 0x1.dac670561bb4fp-2;
+static const double ATAN_HALF_LO = 0x1.a2b7f222f65e2p-56;
+static const double PIO4_HI = 0x1.921fb54442d18p-1;
+static const double PIO4_LO = 0x1.1a62633145c07p-55;
+static const double PIO2_HI = 0x1.921fb54442d18p+0;
+static const double PIO2_LO = 0x1.1a62633145c07p-54;
+static const double PI_HI = 0x1.921fb54442d18p+1;
+static const double PI_LO = 0x1.1a62633145c07p-53;
+
+// hi + lo = (ch + cl) - (hi + lo)
+template <class M>
+static inline void subtractFrom(
+    double ch, double cl, typename M::Real& hi, typename M::Real& lo
+) {
+    typename M::Real e;
+    twoSum<M>(M::constant(ch), -hi, hi, e);
+    lo = e + (M::constant(cl) - lo);
+}
+
+template <class M>
+static typename M::Real arcTangent2(typename M::Real y, typename M::Real x) {
+    typedef typename M::Real Real;
+    typedef typename M::Mask Mask;
+    Real ax = M::abs(x), ay = M::abs(y);
+    Real zero = M::constant(0.), one = M::constant(1.);
+    Real inf = M::constant(INFINITY);
+    Mask reduced = M::both(
+        M::both(M::less(zero, ax), M::less(ax, inf)),
+        M::both(M::less(zero, ay), M::less(ay, inf))
+    );
+    Mask swap = M::less(ax, ay);
+    Real num = M::select(reduced, M::select(swap, ax, ay), zero);
+    Real den = M::select(reduced, M::select(swap, ay, ax), one);
+    // The same ratio of numbers, whose products can be split
+    Real factor = M::select(
+        M::less(den, M::constant(0x1p-400)), M::constant(0x1p600),
+        M::select(
+            M::lessEqual(M::constant(0x1p600), den), M::constant(0x1p-600), one
+        )
+    );
+    num = num * factor;
+    den = den * factor;
+    // t = num / den = th + tl
+    Real th = num / den;
+    Real ph, pl;
+    twoProduct<M>(th, den, ph, pl);
+    Real tl = ((num - ph) - pl) / den;
+
+    Mask middle = M::less(M::constant(7. / 16), th);
+    Mask high = M::less(M::constant(11. / 16), th);
+    Real c = M::select(high, one, M::select(middle, M::constant(0.5), zero));
+    Real atanHi = M::select(
+        high, M::constant(PIO4_HI),
+        M::select(middle, M::constant(ATAN_HALF_HI), zero)
+    );
+    Real atanLo = M::select(
+        high, M::constant(PIO4_LO),
+        M::select(middle, M::constant(ATAN_HALF_LO), zero)
+    );
+    // u = (t - c) / (1 + c t) = uh + ul; t - c and c * th are exact
+    Real n = th - c;
+    Real dh, dl;
+    twoSum<M>(one, c * th, dh, dl);
+    dl = dl + c * tl;
+    Real uh = (n + tl) / dh;
+    twoProduct<M>(uh, dh, ph, pl);
+    Real ul = (((n - ph) - pl) + tl - uh * dl) / dh;
+    // a = atan(c) + u + u^3 g(u^2)
+    Real z = uh * uh;
+    Real ah, al;
+    fastTwoSum<M>(atanHi, uh, ah, al);
+    al = al + (ul + atanLo +
+        uh * z * polynomial<M, 0>(z, ATAN_COEFFICIENTS));
+
+    Real bh = ah, bl = al;
+    subtractFrom<M>(PIO2_HI, PIO2_LO, bh, bl);
+    ah = M::select(swap, bh, ah);
+    al = M::select(swap, bl, al);
+    bh = ah, bl = al;
+    subtractFrom<M>(PI_HI, PI_LO, bh, bl);
+    Mask negative = M::less(x, zero);
+    ah = M::select(negative, bh, ah);
+    al = M::select(negative, bl, al);
+    Real res = M::copySign(ah + al, y);
+    return M::fallback(M::invert(reduced), res, y, x, atan2);
+}
+
+double rpnSin(double x) { return sinCos<ScalarMath>(x, false); }
+double rpnCos(double x) { return sinCos<ScalarMath>(x, true); }
+double rpnExp(double x) { return exponential<ScalarMath>(x); }
+double rpnLog(double x) { return logarithm<ScalarMath>(x); }
+double rpnSqrt(double x) { return sqrt(x); }
+double rpnPow(double x, double y) { return power<ScalarMath>(x, y); }
+double rpnAtan2(double y, double x) { return arcTangent2<ScalarMath>(y, x); }
+
+#ifdef __SSE2__
+__m128d rpnSin(__m128d x) { return sinCos<SseMath>(x, false); }
+__m128d rpnCos(__m128d x) { return sinCos<SseMath>(x, true); }
+__m128d rpnExp(__m128d x) { return exponential<SseMath>(x); }
+__m128d rpnLog(__m128d x) { return logarithm<SseMath>(x); }
+__m128d rpnSqrt(__m128d x) { return _mm_sqrt_pd(x); }
+__m128d rpnPow(__m128d x, __m128d y) { return power<SseMath>(x, y); }
+__m128d rpnAtan2(__m128d y, __m128d x) { return arcTangent2<SseMath>(y, x); }
+
+#   define RPN_ARRAY_FUNCTION(name)                                     \
+void name(double* dst, const double* x, int n) {                        \
+    int i = 0;                                                          \
+    for (; i + 2 <= n; i += 2)                                          \
+        _mm_storeu_pd(dst + i, name(_mm_loadu_pd(x + i)));              \
+    for (; i < n; ++i)                                                  \
+        dst[i] = name(x[i]);                                            \
+}
+#else
+#   define RPN_ARRAY_FUNCTION(name)                                     \
+void name(double* dst, const double* x, int n) {                        \
+    for (int i = 0; i < n; ++i)                                         \
+        dst[i] = name(x[i]);                                            \
+}
+#endif
+
+RPN_ARRAY_FUNCTION(rpnSin)
+RPN_ARRAY_FUNCTION(rpnCos)
+RPN_ARRAY_FUNCTION(rpnExp)
+RPN_ARRAY_FUNCTION(rpnLog)
+RPN_ARRAY_FUNCTION(rpnSqrt)
+
+#undef RPN_ARRAY_FUNCTION
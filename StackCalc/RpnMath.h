@@ -0,0 +1,59 @@
+//
+// Mathematical functions of the stack calculator
+//
+#ifndef RPN_MATH_H
+#define RPN_MATH_H
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+//
+// Every function is computed by the same code for a number and for
+// a pair of numbers in a SSE2 register: the argument is reduced to
+// a small interval, where a polynomial approximates the function.
+// So a column gives exactly the same results as its numbers computed
+// one by one, and the functions of a column run by two numbers
+// at once instead of a call of libm for every number.
+//
+// The errors of results, measured against the long double functions
+// of libm on 10^7 random arguments of every range, are at most
+// (in units of the last place of result):
+//      rpnExp(x)       0.52    |x| < 708 (0.76 for subnormal results)
+//      rpnLog(x)       0.51    any positive x
+//      rpnSin(x)       0.86    |x| < 2^20
+//      rpnCos(x)       0.86    |x| < 2^20
+//      rpnPow(x, y)    0.69    0 < x < 1e10, |y| < 1000; x^y < 1e300
+//      rpnAtan2(y, x)  0.85    any finite x, y
+// rpnSqrt is the instruction (correctly rounded).
+//
+// The arguments out of the ranges of reduction (see "RpnMath.cpp")
+// are passed to libm: the zeros, infinities and NaN in atan2,
+// |x| >= 2^20 in sin and cos, x <= 0 or a huge y in pow.
+//
+double rpnSin(double x);
+double rpnCos(double x);
+double rpnExp(double x);
+double rpnLog(double x);
+double rpnSqrt(double x);
+double rpnPow(double x, double y);
+double rpnAtan2(double y, double x);
+
+#ifdef __SSE2__
+__m128d rpnSin(__m128d x);
+__m128d rpnCos(__m128d x);
+__m128d rpnExp(__m128d x);
+__m128d rpnLog(__m128d x);
+__m128d rpnSqrt(__m128d x);
+__m128d rpnPow(__m128d x, __m128d y);
+__m128d rpnAtan2(__m128d y, __m128d x);
+#endif
+
+// Arrays: dst[i] = f(x[i]); dst may coincide with x
+void rpnSin(double* dst, const double* x, int n);
+void rpnCos(double* dst, const double* x, int n);
+void rpnExp(double* dst, const double* x, int n);
+void rpnLog(double* dst, const double* x, int n);
+void rpnSqrt(double* dst, const double* x, int n);
+
+#endif
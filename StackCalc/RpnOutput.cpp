@@ -0,0 +1,67 @@
+//
+// Buffered output of the stack calculator
+//
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <charconv>
+#include "RpnOutput.h"
+
+RpnOutput rpnStandardOutput;
+
+void RpnOutput::put(const char* s) {
+    put(s, strlen(s));
+}
+
+void RpnOutput::put(const char* s, size_t n) {
+    while (n > 0) {
+        if (length >= buffer.size())
+            flush();
+        size_t len = buffer.size() - length;
+        if (len > n)
+            len = n;
+        memcpy(&(buffer[length]), s, len);
+        length += len;
+        s += len;
+        n -= len;
+    }
+}
+
+void RpnOutput::putNumber(double x) {
+    if (buffer.size() - length < 32)
+        flush();
+    char* p = &(buffer[length]);
+    std::to_chars_result r;
+    if (precision > 0) {
+        r = std::to_chars(
+            p, p + 32, x, std::chars_format::general, precision
+        );
+    } else {
+        r = std::to_chars(p, p + 32, x);
+    }
+    length += r.ptr - p;
+}
+
+void RpnOutput::putInteger(long n) {
+    if (buffer.size() - length < 24)
+        flush();
+    char* p = &(buffer[length]);
+    std::to_chars_result r = std::to_chars(p, p + 24, n);
+    length += r.ptr - p;
+}
+
+void RpnOutput::flush() {
+    const char* p = &(buffer[0]);
+    size_t n = length;
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            break;          // The output is lost
+        }
+        p += w;
+        n -= (size_t) w;
+    }
+    length = 0;
+}
@@ -0,0 +1,57 @@
+//
+// Buffered output of the stack calculator
+//
+#ifndef RPN_OUTPUT_H
+#define RPN_OUTPUT_H
+
+#include <stddef.h>
+#include <vector>
+
+//
+// The output is collected in a large buffer and written to the file
+// descriptor by write() when the buffer is full or by flush().
+// The numbers are converted by std::to_chars: with precision 0,
+// the shortest representation that reads back to the same number,
+// otherwise as by printf("%.<precision>g").
+//
+class RpnOutput {
+    int                 fd;
+    std::vector<char>   buffer;
+    size_t              length;     // Used part of buffer
+    int                 precision;
+
+public:
+    RpnOutput(int outputFd = 1, size_t size = 1 << 20):
+        fd(outputFd),
+        buffer(size < 64? 64 : size),
+        length(0),
+        precision(0)
+    {}
+
+    ~RpnOutput() { flush(); }
+
+    void put(char c) {
+        if (length >= buffer.size())
+            flush();
+        buffer[length++] = c;
+    }
+    void put(const char* s);
+    void put(const char* s, size_t n);
+    void putNumber(double x);
+    void putInteger(long n);
+
+    // Write the buffer
+    void flush();
+
+    int getPrecision() const { return precision; }
+    void setPrecision(int p) { precision = p; }
+
+private:
+    RpnOutput(const RpnOutput&);                // Not implemented
+    RpnOutput& operator=(const RpnOutput&);     // Not implemented
+};
+
+// Output to the standard output (flushed at exit)
+extern RpnOutput rpnStandardOutput;
+
+#endif
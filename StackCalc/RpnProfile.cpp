@@ -0,0 +1,106 @@
+//
+// Profile of the interpreter of the stack calculator
+//
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <algorithm>
+#include "RpnProfile.h"
+
+static RpnProfile total;
+static std::mutex totalLock;
+
+void RpnProfile::clear() {
+    memset(counts, 0, sizeof(counts));
+    memset(cycles, 0, sizeof(cycles));
+    memset(samples, 0, sizeof(samples));
+    programs = 0;
+    growths = 0;
+    maxDepth = 0;
+}
+
+void RpnProfile::add(const RpnProfile& p) {
+    for (int i = 0; i < RPN_NUM_OPCODES; ++i) {
+        counts[i] += p.counts[i];
+        cycles[i] += p.cycles[i];
+        samples[i] += p.samples[i];
+    }
+    programs += p.programs;
+    growths += p.growths;
+    if (p.maxDepth > maxDepth)
+        maxDepth = p.maxDepth;
+}
+
+void rpnProfileAdd(const RpnProfile& p) {
+    std::lock_guard<std::mutex> guard(totalLock);
+    total.add(p);
+}
+
+#ifdef RPN_PROFILE
+// Put the text and spaces up to the width
+static void putColumn(RpnOutput& out, const char* s, int width) {
+    int n = (int) strlen(s);
+    out.put(s, n);
+    for (; n < width; ++n)
+        out.put(' ');
+}
+
+class ByCount {
+    const RpnProfile& profile;
+public:
+    ByCount(const RpnProfile& p): profile(p) {}
+    bool operator()(int a, int b) const {
+        return profile.counts[a] > profile.counts[b];
+    }
+};
+#endif
+
+void rpnProfilePrint(RpnOutput& out) {
+#ifndef RPN_PROFILE
+    out.put("No profile: compile with RPN_PROFILE defined\n");
+#else
+    RpnProfile p;
+    {
+        std::lock_guard<std::mutex> guard(totalLock);
+        p = total;
+    }
+    long long instructions = 0;
+    int opcodes[RPN_NUM_OPCODES];
+    for (int i = 0; i < RPN_NUM_OPCODES; ++i) {
+        instructions += p.counts[i];
+        opcodes[i] = i;
+    }
+    std::stable_sort(opcodes, opcodes + RPN_NUM_OPCODES, ByCount(p));
+
+    out.put("Programs executed: ");
+    out.putInteger((long) p.programs);
+    out.put("\nInstructions executed: ");
+    out.putInteger((long) instructions);
+    out.put("\nMaximal depth of stack: ");
+    out.putInteger(p.maxDepth);
+    out.put("\nGrowths of stack: ");
+    out.putInteger((long) p.growths);
+    out.put(
+        "\nOpcode      Count           %     Cycles (average of samples)\n"
+    );
+    for (int k = 0; k < RPN_NUM_OPCODES; ++k) {
+        int i = opcodes[k];
+        if (p.counts[i] == 0)
+            break;
+        putColumn(out, rpnOpcodeName(i), 12);
+        char number[32];
+        snprintf(number, sizeof(number), "%lld", p.counts[i]);
+        putColumn(out, number, 12);
+        snprintf(
+            number, sizeof(number), "%5.1f",
+            100. * (double) p.counts[i] / (double) instructions
+        );
+        putColumn(out, number, 10);
+        if (p.samples[i] > 0)
+            out.putInteger((long)(p.cycles[i] / p.samples[i]));
+        else
+            out.put('-');
+        out.put('\n');
+    }
+#endif
+}
@@ -0,0 +1,106 @@
+//
+// Profile of the interpreter of the stack calculator
+//
+#ifndef RPN_PROFILE_H
+#define RPN_PROFILE_H
+
+#include "RpnProgram.h"
+#include "RpnOutput.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#else
+#   include <time.h>
+#endif
+
+//
+// The profile is collected, if the interpreter is compiled with
+// RPN_PROFILE defined (make CFLAGS="-O2 -DRPN_PROFILE"); otherwise
+// the interpreter has no instrumentation at all, and the command
+// "stats" only says so. The interpreter counts the executions
+// of every opcode, samples the time of some of them by the time
+// stamp counter of processor, and finds the maximal depth of stack
+// and the number of times the stack grew (moved to a larger array).
+// Every execution of a program collects its own profile, which is
+// added to the total one at its end, so the threads of the batch
+// mode and the server do not share counters in the loop. The command
+// "stats" prints the total of the executions finished before it.
+//
+class RpnProfile {
+public:
+    long long   counts[RPN_NUM_OPCODES];    // Executions
+    long long   cycles[RPN_NUM_OPCODES];    // Time of the samples
+    long long   samples[RPN_NUM_OPCODES];
+    long long   programs;                   // Executions of programs
+    long long   growths;                    // Of the stack
+    int         maxDepth;                   // Of the stack
+
+    RpnProfile() { clear(); }
+
+    void clear();
+    void add(const RpnProfile& p);
+};
+
+// Time stamp counter (or nanoseconds, where there is no TSC)
+inline unsigned long long rpnTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long) t.tv_sec * 1000000000ULL + t.tv_nsec;
+#endif
+}
+
+//
+// Profile of an execution (used by the interpreter). An instruction
+// is timed from its dispatch to the dispatch of the next one (with
+// the overhead of reading the counter, about 20-30 cycles); the gaps
+// between the timed instructions are random (1 to 32 instructions),
+// so that the samples of a loop are not always the same opcodes.
+//
+class RpnProfiler {
+public:
+    RpnProfile          profile;
+    unsigned            random;     // State of xorshift
+    int                 countdown;  // Instructions to the next sample
+    int                 timed;      // Opcode being timed or -1
+    unsigned long long  start;
+
+    RpnProfiler():
+        profile(),
+        random(2463534242U),
+        countdown(1),
+        timed(-1),
+        start(0)
+    {}
+
+    // Before the instruction op with the depth of stack d
+    void step(int op, int d) {
+        ++profile.counts[op];
+        if (d > profile.maxDepth)
+            profile.maxDepth = d;
+        if (timed >= 0) {
+            profile.cycles[timed] += (long long)(rpnTimestamp() - start);
+            ++profile.samples[timed];
+            timed = (-1);
+        }
+        if (--countdown == 0) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            countdown = 1 + (int)(random & 31);
+            timed = op;
+            start = rpnTimestamp();
+        }
+    }
+};
+
+// Add the profile of an execution to the total profile
+// (can be called by several threads)
+void rpnProfileAdd(const RpnProfile& p);
+
+// Print the total profile (the command "stats")
+void rpnProfilePrint(RpnOutput& out);
+
+#endif
@@ -0,0 +1,636 @@
+//
+// Compiler of the stack calculator programs
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "RpnProgram.h"
+#include "RpnTokenizer.h"
+#include "RpnDictionary.h"
+#include "RpnMath.h"
+
+static const char* const opcodeNames[RPN_NUM_OPCODES] = {
+#define RPN_OPCODE_NAME(name, pops, pushes) #name,
+    RPN_OPCODE_LIST(RPN_OPCODE_NAME)
+#undef RPN_OPCODE_NAME
+};
+
+static const int opcodePops[RPN_NUM_OPCODES] = {
+#define RPN_OPCODE_POPS(name, pops, pushes) pops,
+    RPN_OPCODE_LIST(RPN_OPCODE_POPS)
+#undef RPN_OPCODE_POPS
+};
+
+static const int opcodePushes[RPN_NUM_OPCODES] = {
+#define RPN_OPCODE_PUSHES(name, pops, pushes) pushes,
+    RPN_OPCODE_LIST(RPN_OPCODE_PUSHES)
+#undef RPN_OPCODE_PUSHES
+};
+
+static_assert(
+    RPN_PUSH_SUB - RPN_PUSH_ADD == RPN_SUB - RPN_ADD &&
+    RPN_PUSH_MUL - RPN_PUSH_ADD == RPN_MUL - RPN_ADD &&
+    RPN_PUSH_DIV - RPN_PUSH_ADD == RPN_DIV - RPN_ADD,
+    "Superinstructions must follow the order of operations"
+);
+
+const char* rpnOpcodeName(int opcode) {
+    if (opcode < 0 || opcode >= RPN_NUM_OPCODES)
+        return "?";
+    return opcodeNames[opcode];
+}
+
+void RpnProgram::clear() {
+    code.clear();
+    code.push_back(rpnInstruction(RPN_END));
+    constants.clear();
+    analyze();
+}
+
+void RpnProgram::add(int opcode, int operand /* = 0 */) {
+    assert(code.size() > 0 && rpnOpcode(code.back()) == RPN_END);
+    code.back() = rpnInstruction(opcode, operand);
+    code.push_back(rpnInstruction(RPN_END));
+}
+
+void RpnProgram::addConstant(double x) {
+    if ((int) constants.size() >= RPN_MAX_OPERAND)
+        throw RpnSyntaxException("Too many constants", "");
+    add(RPN_PUSH, (int) constants.size());
+    constants.push_back(x);
+}
+
+// Maximal length of a word without jumps, which is copied
+// to the place of call
+const int RPN_INLINE_SIZE = 16;
+
+static bool isBinary(int op) {
+    return (
+        (op >= RPN_ADD && op <= RPN_ATAN2) || (op >= RPN_LT && op <= RPN_NE)
+    );
+}
+
+static bool isUnary(int op) {
+    return (op >= RPN_SIN && op <= RPN_SQRT);
+}
+
+static bool isJump(int op) {
+    return (op == RPN_JMP || op == RPN_JZ || op == RPN_DO || op == RPN_LOOP);
+}
+
+// The operand is an index in the constant pool
+static bool usesConstant(int op) {
+    return (op == RPN_PUSH || (op >= RPN_PUSH_ADD && op <= RPN_PUSH_DIV));
+}
+
+static double fold(int op, double x, double y) {
+    switch (op) {
+    case RPN_ADD: return x + y;
+    case RPN_SUB: return x - y;
+    case RPN_MUL: return x * y;
+    case RPN_DIV: return x / y;
+    case RPN_LT:  return (x < y? 1. : 0.);
+    case RPN_GT:  return (x > y? 1. : 0.);
+    case RPN_LE:  return (x <= y? 1. : 0.);
+    case RPN_GE:  return (x >= y? 1. : 0.);
+    case RPN_EQ:  return (x == y? 1. : 0.);
+    case RPN_NE:  return (x != y? 1. : 0.);
+    case RPN_POW: return rpnPow(x, y);
+    case RPN_ATAN2: return rpnAtan2(x, y);
+    case RPN_SIN: return rpnSin(x);
+    case RPN_COS: return rpnCos(x);
+    case RPN_EXP: return rpnExp(x);
+    case RPN_LOG: return rpnLog(x);
+    case RPN_SQRT: return rpnSqrt(x);
+    default:      return fmod(x, y);
+    }
+}
+
+// The instructions are added to the result one by one, and every
+// rule looks only at the end of result after the last jump target.
+// So a rule never crosses "=" or "show" (they stay between the
+// instructions) or the beginning of a basic block, and the constants
+// of the result are in the order of instructions, every one used
+// once: the constants of the last instruction are the last ones
+// in the pool. The jump targets are moved at the end.
+void RpnProgram::optimize() {
+    analyze();
+    int needed = minDepth;
+    bool exhausted = underflow;
+
+    int size = (int) code.size();
+    std::vector<bool> target(size, false);
+    for (int i = 0; i < size; ++i) {
+        if (isJump(rpnOpcode(code[i])))
+            target[rpnOperand(code[i])] = true;
+    }
+    std::vector<int> position(size);    // New indices of instructions
+    std::vector<RpnInstruction> res;
+    std::vector<double> pool;
+    res.reserve(size);
+    pool.reserve(constants.size());
+    int block = 0;          // Beginning of the current basic block
+    for (int i = 0; i + 1 < size; ++i) {    // Without END
+        if (target[i])
+            block = (int) res.size();
+        position[i] = (int) res.size();
+        RpnInstruction w = code[i];
+        int op = rpnOpcode(w);
+        int n = (int) res.size() - block;
+        int last = (n > 0? rpnOpcode(res[res.size()-1]) : RPN_END);
+        int prev = (n > 1? rpnOpcode(res[res.size()-2]) : RPN_END);
+
+        if (usesConstant(op)) {
+            res.push_back(rpnInstruction(op, (int) pool.size()));
+            pool.push_back(constants[rpnOperand(w)]);
+        } else if (isBinary(op) && last == RPN_PUSH && prev == RPN_PUSH) {
+            double y = pool.back();
+            pool.pop_back();
+            res.pop_back();
+            pool.back() = fold(op, pool.back(), y);
+        } else if (isUnary(op) && last == RPN_PUSH) {
+            pool.back() = fold(op, pool.back(), 0.);
+        } else if (op >= RPN_ADD && op <= RPN_DIV && last == RPN_PUSH) {
+            res.back() = rpnInstruction(
+                RPN_PUSH_ADD + (op - RPN_ADD), rpnOperand(res.back())
+            );
+        } else if (op == RPN_EXCH && last == RPN_EXCH) {
+            res.pop_back();
+        } else if (op == RPN_POP && last == RPN_DUP) {
+            res.pop_back();
+        } else if (op == RPN_POP && last == RPN_PUSH) {
+            res.pop_back();
+            pool.pop_back();
+        } else {
+            res.push_back(w);
+        }
+    }
+    position[size - 1] = (int) res.size();
+    res.push_back(rpnInstruction(RPN_END));
+    for (size_t i = 0; i < res.size(); ++i) {
+        int op = rpnOpcode(res[i]);
+        if (isJump(op))
+            res[i] = rpnInstruction(op, position[rpnOperand(res[i])]);
+    }
+    code.swap(res);
+    constants.swap(pool);
+
+    analyze();
+    if (needed > minDepth)
+        minDepth = needed;
+    underflow = (underflow || exhausted);
+}
+
+void RpnProgram::compile(const char* text, bool echo /* = false */) {
+    RpnTokenizer tokens(text);
+    compile(tokens, echo, false);
+}
+
+bool RpnProgram::compile(
+    RpnTokenizer& tokens, bool echo /* = false */, bool line /* = false */
+) {
+    bool more;
+    try {
+        more = compileTokens(tokens, echo, line, false);
+    } catch (RpnSyntaxException&) {
+        if (line)
+            tokens.skipLine();
+        throw;
+    }
+    optimize();
+    return more;
+}
+
+bool RpnProgram::compileCommand(RpnTokenizer& tokens, bool echo /* = false */) {
+    bool more = compileTokens(tokens, echo, true, false, true);
+    optimize();
+    return more;
+}
+
+// Any word beginning with q is "quit" (see RpnTokenizer),
+// unless it is a name defined
+static bool isQuit(const RpnToken& token, const RpnDictionary* dictionary) {
+    int index;
+    return (
+        dictionary == 0 ||
+        dictionary->find(token.str(), index) == RPN_NAME_NONE
+    );
+}
+
+// A name of a new word or variable (may be on the next line)
+static std::string readName(RpnTokenizer& tokens, RpnToken& token) {
+    do {
+        tokens.next(token);
+    } while (token.kind == RPN_TOKEN_NEWLINE);
+    if (token.kind == RPN_TOKEN_END)
+        throw RpnSyntaxException("Missing name", "");
+    std::string name = token.str();
+    if (
+        token.kind != RPN_TOKEN_UNKNOWN &&
+        !(token.kind == RPN_TOKEN_COMMAND && token.opcode == RPN_QUIT &&
+            name != "quit")
+    )
+        throw RpnSyntaxException("Reserved name", name);
+    return name;
+}
+
+static bool inLoop(const std::vector<RpnProgram::Control>& control) {
+    for (size_t i = 0; i < control.size(); ++i) {
+        if (control[i].keyword == RPN_KEYWORD_DO)
+            return true;
+    }
+    return false;
+}
+
+// Compile the tokens up to the end of input, up to ";" in a
+// definition or, with line, up to the end of line outside of
+// control structures; with command, only one command of the line.
+// Return value: false at the end of input or after "quit"
+// (with command, also at the end of line)
+bool RpnProgram::compileTokens(
+    RpnTokenizer& tokens, bool echo, bool line, bool definition,
+    bool command /* = false */
+) {
+    std::vector<Control> control;
+    RpnToken token;
+    bool more = true;
+    while (true) {
+        tokens.next(token);
+        if (
+            token.kind == RPN_TOKEN_COMMAND && token.opcode == RPN_QUIT &&
+            !isQuit(token, dictionary)
+        )
+            token.kind = RPN_TOKEN_UNKNOWN;
+        bool top = (!definition && control.empty());
+
+        if (token.kind == RPN_TOKEN_END) {
+            if (definition)
+                throw RpnSyntaxException("Unfinished definition", "");
+            if (!control.empty()) {
+                throw RpnSyntaxException(
+                    "Unfinished control structure", ""
+                );
+            }
+            more = false;
+            break;
+        } else if (token.kind == RPN_TOKEN_NEWLINE) {
+            if (line && top) {
+                more = !command;
+                break;
+            }
+            continue;
+        } else if (token.kind == RPN_TOKEN_COMMAND) {
+            int op = token.opcode;
+            if (op == RPN_CLEAR && definition) {
+                throw RpnSyntaxException(
+                    "Not allowed in a definition", "clear"
+                );
+            }
+            if (op == RPN_INDEX && !inLoop(control))
+                throw RpnSyntaxException("Not in a loop", "i");
+            add(op);
+            if (echo && top && op >= RPN_ADD && op <= RPN_SQRT)
+                add(RPN_DISPLAY);
+            if (op == RPN_QUIT && top) {
+                more = false;
+                break;          // The rest of input is ignored
+            }
+        } else if (token.kind == RPN_TOKEN_NUMBER) {
+            addConstant(token.value);
+        } else if (
+            token.kind == RPN_TOKEN_FIELD && token.field < RPN_MAX_OPERAND
+        ) {
+            add(RPN_COLUMN, token.field);
+        } else if (token.kind == RPN_TOKEN_KEYWORD) {
+            if (token.opcode == RPN_KEYWORD_SEMICOLON && definition) {
+                if (!control.empty()) {
+                    throw RpnSyntaxException(
+                        "Unfinished control structure", ";"
+                    );
+                }
+                break;
+            }
+            compileKeyword(token.opcode, tokens, token, control, definition);
+        } else if (token.kind == RPN_TOKEN_UNKNOWN) {
+            compileName(token.str());
+        } else {
+            throw RpnSyntaxException("Unknown command", token.str());
+        }
+        if (command && control.empty())
+            break;
+    }
+    return more;
+}
+
+void RpnProgram::compileKeyword(
+    int keyword, RpnTokenizer& tokens, RpnToken& token,
+    std::vector<Control>& control, bool definition
+) {
+    if (here() >= RPN_MAX_OPERAND)
+        throw RpnSyntaxException("Program is too long", "");
+    // The innermost control structure and the one around it
+    int k = (int) control.size();
+    int open = (k > 0? control[k-1].keyword : (-1));
+    int outer = (k > 1? control[k-2].keyword : (-1));
+    Control c;
+    c.keyword = keyword;
+    c.position = here();
+    std::string name;
+    int index;
+
+    switch (keyword) {
+    case RPN_KEYWORD_COLON:
+        if (definition || k > 0)
+            throw RpnSyntaxException("Nested definition", ":");
+        define(tokens, token);
+        return;
+    case RPN_KEYWORD_VARIABLE:
+        name = readName(tokens, token);
+        if (dictionary == 0)
+            throw RpnSyntaxException("No dictionary for", name);
+        if (dictionary->numVariables() >= RPN_MAX_OPERAND)
+            throw RpnSyntaxException("Too many variables", name);
+        dictionary->defineVariable(name);
+        return;
+    case RPN_KEYWORD_TO:
+        name = readName(tokens, token);
+        if (
+            dictionary == 0 ||
+            dictionary->find(name, index) != RPN_NAME_VARIABLE
+        )
+            throw RpnSyntaxException("Not a variable", name);
+        add(RPN_STORE, index);
+        return;
+    case RPN_KEYWORD_IF:
+        add(RPN_JZ);
+        control.push_back(c);
+        return;
+    case RPN_KEYWORD_ELSE:
+        if (open != RPN_KEYWORD_IF)
+            break;
+        add(RPN_JMP);
+        patch(control[k-1].position, here());
+        control[k-1] = c;
+        return;
+    case RPN_KEYWORD_THEN:
+        if (open != RPN_KEYWORD_IF && open != RPN_KEYWORD_ELSE)
+            break;
+        patch(control[k-1].position, here());
+        control.pop_back();
+        return;
+    case RPN_KEYWORD_BEGIN:
+        control.push_back(c);
+        return;
+    case RPN_KEYWORD_UNTIL:
+        if (open != RPN_KEYWORD_BEGIN)
+            break;
+        add(RPN_JZ, control[k-1].position);
+        control.pop_back();
+        return;
+    case RPN_KEYWORD_WHILE:
+        if (open != RPN_KEYWORD_BEGIN)
+            break;
+        add(RPN_JZ);
+        control.push_back(c);
+        return;
+    case RPN_KEYWORD_REPEAT:
+        if (open != RPN_KEYWORD_WHILE || outer != RPN_KEYWORD_BEGIN)
+            break;
+        add(RPN_JMP, control[k-2].position);
+        patch(control[k-1].position, here());
+        control.pop_back();
+        control.pop_back();
+        return;
+    case RPN_KEYWORD_DO:
+        add(RPN_DO);
+        control.push_back(c);
+        return;
+    case RPN_KEYWORD_LOOP:
+        if (open != RPN_KEYWORD_DO)
+            break;
+        add(RPN_LOOP, control[k-1].position + 1);
+        patch(control[k-1].position, here());
+        control.pop_back();
+        return;
+    }
+    throw RpnSyntaxException("Unexpected command", token.str());
+}
+
+// ": name ... ;" (after ":")
+void RpnProgram::define(RpnTokenizer& tokens, RpnToken& token) {
+    std::string name = readName(tokens, token);
+    if (dictionary == 0)
+        throw RpnSyntaxException("No dictionary for", name);
+    if (dictionary->numWords() >= RPN_MAX_OPERAND)
+        throw RpnSyntaxException("Too many words", name);
+    RpnProgram* word = new RpnProgram(dictionary);
+    try {
+        word->compileTokens(tokens, false, false, true);
+        word->optimize();
+    } catch (...) {
+        delete word;
+        throw;
+    }
+    dictionary->defineWord(name, word);
+}
+
+// A word or variable
+void RpnProgram::compileName(const std::string& name) {
+    int index;
+    int kind = RPN_NAME_NONE;
+    if (dictionary != 0)
+        kind = dictionary->find(name, index);
+    if (kind == RPN_NAME_VARIABLE) {
+        add(RPN_FETCH, index);
+    } else if (kind == RPN_NAME_WORD) {
+        const RpnProgram& w = dictionary->word(index);
+        if (w.size() - 1 > RPN_INLINE_SIZE || w.hasJumps()) {
+            add(RPN_CALL, index);
+            return;
+        }
+        for (int i = 0; i + 1 < w.size(); ++i) {    // Without END
+            int op = rpnOpcode(w.code[i]);
+            if (!usesConstant(op)) {
+                add(op, rpnOperand(w.code[i]));
+                continue;
+            }
+            if ((int) constants.size() >= RPN_MAX_OPERAND)
+                throw RpnSyntaxException("Too many constants", "");
+            add(op, (int) constants.size());
+            constants.push_back(w.constants[rpnOperand(w.code[i])]);
+        }
+    } else {
+        throw RpnSyntaxException("Unknown command", name);
+    }
+}
+
+void RpnProgram::patch(int position, int target) {
+    int op = rpnOpcode(code[position]);
+    assert(isJump(op));
+    code[position] = rpnInstruction(op, target);
+}
+
+bool RpnProgram::hasJumps() const {
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (isJump(rpnOpcode(code[i])))
+            return true;
+    }
+    return false;
+}
+
+bool RpnProgram::simple() const {
+    for (size_t i = 0; i < code.size(); ++i) {
+        int op = rpnOpcode(code[i]);
+        if (isJump(op) || op == RPN_CALL || op == RPN_STORE)
+            return false;
+    }
+    return true;
+}
+
+// State of stack before an instruction
+class RpnDepthState {
+public:
+    bool    known;      // The instruction is reachable
+    bool    cleared;    // After "clear": the depth is absolute
+    int     depth;      // Relative to the depth before execution
+    int     loops;      // Nesting of loops "do"
+
+    RpnDepthState():
+        known(false),
+        cleared(false),
+        depth(0),
+        loops(0)
+    {}
+};
+
+// Join the state s at the instruction i with the known one
+static void merge(
+    std::vector<RpnDepthState>& states, int i, const RpnDepthState& s
+) {
+    RpnDepthState& t = states[i];
+    if (!t.known) {
+        t = s;
+    } else if (
+        t.cleared != s.cleared || t.depth != s.depth || t.loops != s.loops
+    ) {
+        throw RpnSyntaxException("Unbalanced stack in control structure", "");
+    }
+}
+
+// The depth is counted relative to the depth d before execution,
+// until the first "clear"; after it, the depth is known exactly.
+// The instructions are passed in order: the code of a control
+// structure (see compileKeyword) is reached from above or by
+// a forward jump, so its state is known, when it is passed,
+// and the backward jumps only check the state.
+void RpnProgram::analyze() {
+    int size = (int) code.size();
+    std::vector<RpnDepthState> states(size);
+    RpnDepthState s;
+    s.known = true;
+    minDepth = 0;
+    maxGrowth = 0;
+    maxAfterClear = 0;
+    underflow = false;
+    finalDepth = 0;
+    numColumns = 0;
+    maxCalls = 0;
+    maxLoops = 0;
+    for (int i = 0; i < size; ++i) {
+        if (states[i].known) {
+            if (s.known)
+                merge(states, i, s);
+            s = states[i];
+        } else if (!s.known) {
+            continue;           // Unreachable
+        }
+        states[i] = s;
+
+        int op = rpnOpcode(code[i]);
+        int operand = rpnOperand(code[i]);
+        int pops = opcodePops[op];
+        int pushes = opcodePushes[op];
+        int peak = pushes;      // Maximal growth after pops
+        if (op == RPN_COLUMN && operand >= numColumns) {
+            numColumns = operand + 1;
+        } else if (op == RPN_CALL) {
+            const RpnProgram& w = dictionary->word(operand);
+            pops = w.minDepth;
+            peak = w.minDepth + w.maxGrowth;
+            pushes = w.minDepth + w.finalDepth;
+            if (w.numColumns > numColumns)
+                numColumns = w.numColumns;
+            if (1 + w.maxCalls > maxCalls)
+                maxCalls = 1 + w.maxCalls;
+            if (s.loops + w.maxLoops > maxLoops)
+                maxLoops = s.loops + w.maxLoops;
+        }
+
+        s.depth -= pops;
+        if (!s.cleared) {
+            if (-s.depth > minDepth)
+                minDepth = -s.depth;
+        } else if (s.depth < 0) {
+            underflow = true;
+            s.depth = 0;
+        }
+        int top = s.depth + peak;
+        if (!s.cleared) {
+            if (top > maxGrowth)
+                maxGrowth = top;
+        } else if (top > maxAfterClear) {
+            maxAfterClear = top;
+        }
+        s.depth += pushes;
+
+        switch (op) {
+        case RPN_CLEAR:
+            s.cleared = true;
+            s.depth = 0;
+            break;
+        case RPN_JMP:
+            merge(states, operand, s);
+            s.known = false;
+            break;
+        case RPN_JZ:
+            merge(states, operand, s);
+            break;
+        case RPN_DO:
+            merge(states, operand, s);      // The loop is skipped
+            ++s.loops;
+            if (s.loops > maxLoops)
+                maxLoops = s.loops;
+            break;
+        case RPN_LOOP:
+            merge(states, operand, s);
+            --s.loops;
+            break;
+        case RPN_QUIT:
+            s.known = false;
+            break;
+        case RPN_END:
+            finalDepth = (s.cleared? 0 : s.depth);
+            break;
+        }
+    }
+}
+
+void RpnProgram::print() const {
+    for (size_t i = 0; i < code.size(); ++i) {
+        int op = rpnOpcode(code[i]);
+        int operand = rpnOperand(code[i]);
+        printf("%4d  %s", (int) i, rpnOpcodeName(op));
+        if (usesConstant(op))
+            printf(" %.17g", constants[operand]);
+        else if (op == RPN_COLUMN)
+            printf(" $%d", operand + 1);
+        else if (
+            isJump(op) || op == RPN_CALL ||
+            op == RPN_FETCH || op == RPN_STORE
+        )
+            printf(" %d", operand);
+        printf("\n");
+    }
+}
@@ -0,0 +1,264 @@
+//
+// Compiled program of the stack calculator (bytecode)
+//
+#ifndef RPN_PROGRAM_H
+#define RPN_PROGRAM_H
+
+#include <vector>
+#include <string>
+
+// List of opcodes: X(name, pops, pushes), where pops and pushes
+// are the numbers of stack elements removed and added.
+// PUSH_ADD ... PUSH_DIV are the superinstructions made by the
+// optimizer from PUSH followed by ADD ... DIV (in the same order).
+// The stack effect of CALL is that of the word.
+#define RPN_OPCODE_LIST(X) \
+    X(PUSH,     0, 1)   /* Push the constant number operand */  \
+    X(COLUMN,   0, 1)   /* Push the field $k (operand k-1) */   \
+    X(ADD,      2, 1)                                           \
+    X(SUB,      2, 1)                                           \
+    X(MUL,      2, 1)                                           \
+    X(DIV,      2, 1)                                           \
+    X(MOD,      2, 1)                                           \
+    X(POW,      2, 1)   /* x y pow is x^y (see "RpnMath.h") */  \
+    X(ATAN2,    2, 1)   /* y x atan2 */                         \
+    X(SIN,      1, 1)                                           \
+    X(COS,      1, 1)                                           \
+    X(EXP,      1, 1)                                           \
+    X(LOG,      1, 1)                                           \
+    X(SQRT,     1, 1)                                           \
+    X(LT,       2, 1)   /* Comparisons give 1 or 0 */           \
+    X(GT,       2, 1)                                           \
+    X(LE,       2, 1)                                           \
+    X(GE,       2, 1)                                           \
+    X(EQ,       2, 1)                                           \
+    X(NE,       2, 1)                                           \
+    X(PUSH_ADD, 1, 1)   /* Add the constant operand */          \
+    X(PUSH_SUB, 1, 1)   /* Subtract the constant operand */     \
+    X(PUSH_MUL, 1, 1)   /* Multiply by the constant operand */  \
+    X(PUSH_DIV, 1, 1)   /* Divide by the constant operand */    \
+    X(POP,      1, 0)                                           \
+    X(DUP,      1, 2)                                           \
+    X(EXCH,     2, 2)                                           \
+    X(CLEAR,    0, 0)   /* Erase the stack */                   \
+    X(DISPLAY,  0, 0)   /* Print the stack top */               \
+    X(SHOW,     0, 0)   /* Print the stack */                   \
+    X(STATS,    0, 0)   /* Print the profile (RpnProfile.h) */  \
+    X(JMP,      0, 0)   /* Jump to the instruction operand */   \
+    X(JZ,       1, 0)   /* Jump, if the top is 0 */             \
+    X(DO,       2, 0)   /* Begin the loop or jump over it */    \
+    X(LOOP,     0, 0)   /* Next index; jump to the body */      \
+    X(INDEX,    0, 1)   /* Push the index of loop */            \
+    X(CALL,     0, 0)   /* Call the word operand */             \
+    X(FETCH,    0, 1)   /* Push the variable operand */         \
+    X(STORE,    1, 0)   /* Pop to the variable operand */       \
+    X(QUIT,     0, 0)   /* End of input */                      \
+    X(END,      0, 0)   /* End of program or return */
+
+class RpnTokenizer;
+class RpnToken;
+class RpnDictionary;
+
+enum RpnOpcode {
+#define RPN_OPCODE_ENUM(name, pops, pushes) RPN_##name,
+    RPN_OPCODE_LIST(RPN_OPCODE_ENUM)
+#undef RPN_OPCODE_ENUM
+    RPN_NUM_OPCODES
+};
+
+// An instruction is a word: the opcode in the lower 8 bits,
+// the operand (an index in the constant pool, of a field,
+// of an instruction, a word or a variable) in the upper 24 bits
+typedef unsigned RpnInstruction;
+
+const unsigned RPN_OPCODE_BITS = 8;
+const unsigned RPN_OPCODE_MASK = (1U << RPN_OPCODE_BITS) - 1;
+const int RPN_MAX_OPERAND = (1 << (32 - RPN_OPCODE_BITS)) - 1;
+
+inline RpnInstruction rpnInstruction(int opcode, int operand = 0) {
+    return (RpnInstruction) opcode | ((RpnInstruction) operand << RPN_OPCODE_BITS);
+}
+inline int rpnOpcode(RpnInstruction i) { return (int)(i & RPN_OPCODE_MASK); }
+inline int rpnOperand(RpnInstruction i) { return (int)(i >> RPN_OPCODE_BITS); }
+
+// Name of opcode (for messages)
+const char* rpnOpcodeName(int opcode);
+
+class RpnSyntaxException {
+public:
+    const char *reason;
+    std::string token;
+    RpnSyntaxException():
+        reason(""),
+        token()
+    {}
+
+    RpnSyntaxException(const char *cause, const std::string& t):
+        reason(cause),
+        token(t)
+    {}
+};
+
+//
+// The program is compiled once and can be executed many times
+// (see "RpnInterp.h"). The numbers are parsed by the compiler and
+// kept in the constant pool. The depth of stack needed by the
+// program is computed statically, so that the interpreter checks
+// it once before execution instead of checking every operation.
+//
+// The control structures are compiled to jumps to the resolved
+// instructions:
+//      if A then               JZ end; A
+//      if A else B then        JZ else; A; JMP end; else: B
+//      begin A until           begin: A; JZ begin
+//      begin A while B repeat  begin: A; JZ end; B; JMP begin
+//      limit start do A loop   DO end; body: A; LOOP body
+// A control structure must not change the depth of stack (every
+// path through it gives the same depth), so that the depths are
+// still known statically; "do" runs for start <= i < limit,
+// and its body is skipped, if start >= limit.
+//
+// The words ": name ... ;" and variables are kept in a dictionary
+// (see "RpnDictionary.h"). A call is bound to the word, when it is
+// compiled, as in Forth: a later definition of the same name does
+// not change the compiled programs. A short word without jumps is
+// copied to the place of call (and optimized there); other words
+// are called by CALL with the index of word.
+//
+class RpnProgram {
+public:
+    // Open control structure (used by the compiler)
+    class Control {
+    public:
+        int keyword;    // RpnKeyword
+        int position;   // Instruction to patch or the jump target
+    };
+
+private:
+    std::vector<RpnInstruction> code;
+    std::vector<double> constants;
+    RpnDictionary* dictionary;
+    int minDepth;       // Depth of stack needed before execution
+    int maxGrowth;      // Maximal growth of stack before "clear"
+    int maxAfterClear;  // Maximal depth after the first "clear"
+    bool underflow;     // The stack is exhausted after "clear"
+    int finalDepth;     // Growth of stack at the end (without "clear")
+    int numColumns;     // Maximal k of the fields $k used
+    int maxCalls;       // Maximal nesting of calls of words
+    int maxLoops;       // Maximal nesting of loops "do"
+public:
+    // Without dictionary, the names (words and variables) are
+    // unknown commands
+    RpnProgram(RpnDictionary* dict = 0):
+        code(),
+        constants(),
+        dictionary(dict),
+        minDepth(0),
+        maxGrowth(0),
+        maxAfterClear(0),
+        underflow(false),
+        finalDepth(0),
+        numColumns(0),
+        maxCalls(0),
+        maxLoops(0)
+    {
+        code.push_back(rpnInstruction(RPN_END));
+    }
+
+    // Compile the text of program (the commands are separated by
+    // spaces). The token $k (k >= 1) pushes the field k of the
+    // current record (see rpnExecute and "RpnColumns.h"). With echo,
+    // every arithmetic operation displays its result, as in the
+    // interactive calculator. The program is optimized.
+    // Throws RpnSyntaxException for an unknown command.
+    void compile(const char* text, bool echo = false);
+
+    // Compile the tokens up to the end of input or, with line,
+    // up to the end of line (a definition or a control structure
+    // may take several lines). The instructions are added to the
+    // program, and the whole program is optimized. The definitions
+    // are added to the dictionary at once. After a syntax error,
+    // the rest of line is skipped.
+    // Return value: false at the end of input (or after "quit")
+    bool compile(RpnTokenizer& tokens, bool echo = false, bool line = false);
+
+    // Compile one command of the line (a definition or a control
+    // structure is one command) as compile with line does; the rest
+    // of line is not skipped after a syntax error.
+    // Return value: false at the end of line or input (or after "quit")
+    bool compileCommand(RpnTokenizer& tokens, bool echo = false);
+
+    void clear();
+
+    // Add an instruction before the final END
+    void add(int opcode, int operand = 0);
+    void addConstant(double x);
+
+    // Compute the depths of stack (called by compile).
+    // Throws RpnSyntaxException, if a control structure
+    // changes the depth of stack.
+    void analyze();
+
+    // Fold the constant arithmetic, remove the pairs "exch exch",
+    // "dup pop" and "<number> pop", and replace a number followed
+    // by +, -, *, / by a superinstruction (called by compile).
+    // The values printed by "=" and "show" do not change, and the
+    // depth of stack needed is the same as before optimization.
+    void optimize();
+
+    const RpnInstruction* instructions() const { return &(code[0]); }
+    int size() const { return (int) code.size(); }     // With END
+    const double* constantPool() const {
+        return (constants.empty()? 0 : &(constants[0]));
+    }
+    int numConstants() const { return (int) constants.size(); }
+    RpnDictionary* getDictionary() const { return dictionary; }
+
+    // Can the program run with the stack of depth d?
+    bool canRun(int d) const { return (!underflow && d >= minDepth); }
+
+    // Maximal depth of stack during execution, which begins
+    // with the depth d
+    int maxDepth(int d) const {
+        int m = d + maxGrowth;
+        return (m > maxAfterClear? m : maxAfterClear);
+    }
+
+    int neededDepth() const { return minDepth; }
+
+    // Number of fields of a record needed by the program
+    int columns() const { return numColumns; }
+
+    // Depths of the stacks of calls and of loops
+    int callDepth() const { return maxCalls; }
+    int loopDepth() const { return maxLoops; }
+
+    // Has the program jumps (control structures)?
+    bool hasJumps() const;
+
+    // The program has no jumps, calls of words and assignments
+    // of variables, so it can be computed by columns
+    bool simple() const;
+
+    // Print the program (for debugging)
+    void print() const;
+
+private:
+    RpnProgram(const RpnProgram&);              // Not implemented
+    RpnProgram& operator=(const RpnProgram&);   // Not implemented
+
+    bool compileTokens(
+        RpnTokenizer& tokens, bool echo, bool line, bool definition,
+        bool command = false
+    );
+    void compileKeyword(
+        int keyword, RpnTokenizer& tokens, RpnToken& token,
+        std::vector<Control>& control, bool definition
+    );
+    void compileName(const std::string& name);
+    void define(RpnTokenizer& tokens, RpnToken& token);
+    void patch(int position, int target);
+    int here() const { return (int) code.size() - 1; }
+};
+
+#endif
@@ -0,0 +1,281 @@
+//
+// Server of the stack calculator on a Unix domain socket
+//
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <charconv>
+#include "RpnServer.h"
+#include "RpnProgram.h"
+#include "RpnInterp.h"
+#include "RpnTokenizer.h"
+#include "RpnDictionary.h"
+#include "RpnJit.h"
+
+// Number of programs in the cache, when it is cleared
+const size_t RPN_CACHE_SIZE = 4096;
+
+// The connection is closed, if a line is longer
+const size_t RPN_MAX_LINE = 1 << 20;
+
+// The requests of a client are not read, while its responses
+// not yet written are longer (the client does not read them)
+const size_t RPN_MAX_PENDING = 1 << 20;
+
+// Size of a read()
+const size_t RPN_READ_SIZE = 65536;
+
+// A cached program is translated to machine code (see "RpnJit.h"),
+// when it is executed so many times
+const long RPN_JIT_THRESHOLD = 1000;
+
+// poll() wakes up at least so often (ms) to check stop()
+const int RPN_POLL_TIMEOUT = 1000;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+// Compiled program with its own words and variables
+class RpnCachedProgram {
+public:
+    RpnDictionary   dictionary;
+    RpnProgram      program;
+    RpnJitCode      jit;
+    long            executions;
+
+    RpnCachedProgram():
+        dictionary(),
+        program(&dictionary),
+        jit(),
+        executions(0)
+    {}
+};
+
+RpnServer::~RpnServer() {
+    while (!clients.empty())
+        close((int) clients.size() - 1);
+    clearCache();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+bool RpnServer::open(const char* socketPath) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+        return false;
+    unlink(socketPath);
+    if (
+        bind(fd, (const sockaddr*) &address, sizeof(address)) < 0 ||
+        listen(fd, SOMAXCONN) < 0
+    ) {
+        int e = errno;
+        ::close(fd);
+        errno = e;
+        return false;
+    }
+    path = socketPath;
+    listenFd = fd;
+    return true;
+}
+
+void RpnServer::stop() {
+    stopRequested = 1;
+}
+
+void RpnServer::run() {
+    std::vector<pollfd> fds;
+    while (!stopRequested) {
+        fds.resize(clients.size() + 1);
+        fds[0].fd = listenFd;
+        fds[0].events = POLLIN;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            const Client& c = *(clients[i]);
+            size_t pending = c.output.size() - c.written;
+            fds[i+1].fd = c.fd;
+            fds[i+1].events = 0;
+            if (pending > 0)
+                fds[i+1].events |= POLLOUT;
+            if (!c.eof && pending < RPN_MAX_PENDING)
+                fds[i+1].events |= POLLIN;
+        }
+        int n = poll(&(fds[0]), fds.size(), RPN_POLL_TIMEOUT);
+        if (n <= 0)
+            continue;       // Timeout or a signal
+
+        // From the end, as a closed client is removed
+        for (int i = (int) clients.size() - 1; i >= 0; --i) {
+            short r = fds[i+1].revents;
+            if (r == 0)
+                continue;
+            Client& c = *(clients[i]);
+            bool ok = true;
+            if ((r & (POLLIN | POLLHUP | POLLERR)) != 0 && !c.eof)
+                ok = receive(c);
+            if (ok)
+                ok = send(c);
+            if (!ok || (c.eof && c.written == c.output.size()))
+                close(i);
+        }
+        if ((fds[0].revents & POLLIN) != 0)
+            accept();
+    }
+}
+
+void RpnServer::accept() {
+    while (true) {
+        int fd = accept4(listenFd, 0, 0, SOCK_NONBLOCK);
+        if (fd < 0)
+            return;         // EAGAIN: no more connections
+        Client* c = new Client();
+        c->fd = fd;
+        c->written = 0;
+        c->eof = false;
+        clients.push_back(c);
+    }
+}
+
+// Read the requests available and compute the complete lines.
+// Return value: false, if the connection is to be closed
+bool RpnServer::receive(Client& c) {
+    char buffer[RPN_READ_SIZE];
+    ssize_t n = read(c.fd, buffer, sizeof(buffer));
+    if (n < 0)
+        return (errno == EAGAIN || errno == EINTR);
+    if (n == 0)
+        c.eof = true;
+    else
+        c.input.append(buffer, (size_t) n);
+
+    const char* data = c.input.data();
+    size_t begin = 0;
+    while (true) {
+        const char* e = (const char*) memchr(
+            data + begin, '\n', c.input.size() - begin
+        );
+        if (e == 0)
+            break;
+        size_t end = (size_t)(e - data);
+        size_t len = end - begin;
+        if (len > 0 && data[end - 1] == '\r')
+            --len;
+        compute(data + begin, len, c.output);
+        begin = end + 1;
+    }
+    if (c.eof && begin < c.input.size()) {
+        // The last line without '\n'
+        compute(data + begin, c.input.size() - begin, c.output);
+        begin = c.input.size();
+    }
+    c.input.erase(0, begin);
+    return (c.input.size() <= RPN_MAX_LINE);
+}
+
+// Write the responses, as many as the socket accepts.
+// Return value: false, if the connection is to be closed
+bool RpnServer::send(Client& c) {
+    while (c.written < c.output.size()) {
+        ssize_t n = ::send(
+            c.fd, c.output.data() + c.written,
+            c.output.size() - c.written, MSG_NOSIGNAL
+        );
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return (errno == EAGAIN);
+        }
+        c.written += (size_t) n;
+    }
+    c.output.clear();
+    c.written = 0;
+    return true;
+}
+
+void RpnServer::close(int i) {
+    ::close(clients[i]->fd);
+    delete clients[i];
+    clients.erase(clients.begin() + i);
+}
+
+// Compute the request and append the response to out
+void RpnServer::compute(const char* text, size_t length, std::string& out) {
+    key.assign(text, length);
+    try {
+        RpnCachedProgram* p;
+        std::unordered_map<std::string, RpnCachedProgram*>::iterator i =
+            cache.find(key);
+        if (i != cache.end()) {
+            p = i->second;
+        } else {
+            p = compile(text, length);
+            if (cache.size() >= RPN_CACHE_SIZE)
+                clearCache();
+            cache[key] = p;
+        }
+        // A program with fields $k fails in the interpreter
+        if (++p->executions == RPN_JIT_THRESHOLD && p->program.columns() == 0)
+            p->jit.compile(p->program);
+        double value;
+        if (p->jit.compiled()) {
+            value = p->jit.evaluate((const double*) 0);
+        } else {
+            for (int v = 0; v < p->dictionary.numVariables(); ++v)
+                p->dictionary.setVariable(v, 0.);
+            stack.clear();
+            rpnExecute(
+                p->program, stack, 0, 0, &ignored, RPN_MAX_JUMPS
+            );
+            if (stack.empty())
+                throw StackException("Stack empty");
+            value = stack.top();
+        }
+        char number[32];
+        std::to_chars_result r =
+            std::to_chars(number, number + sizeof(number), value);
+        out.append(number, r.ptr);
+    } catch (RpnSyntaxException& e) {
+        out += e.reason;
+        if (!e.token.empty()) {
+            out += ": ";
+            out += e.token;
+        }
+    } catch (StackException& e) {
+        out += "Stack Exception: ";
+        out += e.reason;
+    }
+    out += '\n';
+}
+
+// Throws RpnSyntaxException
+RpnCachedProgram* RpnServer::compile(const char* text, size_t length) {
+    RpnCachedProgram* p = new RpnCachedProgram();
+    try {
+        RpnTokenizer tokens(text, length);
+        p->program.compile(tokens);
+    } catch (RpnSyntaxException&) {
+        delete p;
+        throw;
+    }
+    return p;
+}
+
+void RpnServer::clearCache() {
+    std::unordered_map<std::string, RpnCachedProgram*>::iterator i;
+    for (i = cache.begin(); i != cache.end(); ++i)
+        delete i->second;
+    cache.clear();
+}
@@ -0,0 +1,92 @@
+//
+// Server of the stack calculator on a Unix domain socket
+//
+#ifndef RPN_SERVER_H
+#define RPN_SERVER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "RealStack.h"
+#include "RpnOutput.h"
+
+class RpnCachedProgram;
+
+//
+// A request is a line of text: a program, which is computed from
+// the empty stack with its own words and variables, as in the batch
+// mode (see "RpnBatch.h"). The response is a line with its result
+// (the top of stack, printed exactly) or the error message; a program
+// fails after RPN_MAX_JUMPS repetitions of loops (see "RpnInterp.h"),
+// so that it cannot block the server.
+// A client may send many requests without waiting for the responses
+// (pipelining); the responses come in the order of requests.
+// The server reads all the data available on a connection, computes
+// every complete line, and writes all the responses by one write().
+//
+// The compiled programs are cached by their text, so a repeated
+// request is only executed; the variables of a cached program are
+// set to 0 before every execution. A program executed many times
+// is translated to machine code (see "RpnJit.h"), if it can be.
+// The cache is cleared, when it
+// has RPN_CACHE_SIZE programs. The server is a single thread
+// waiting in poll() for all connections.
+//
+class RpnServer {
+    // Connection with a client
+    class Client {
+    public:
+        int         fd;
+        std::string input;      // Data received, not yet computed
+        std::string output;     // Responses not yet written
+        size_t      written;    // Part of output written
+        bool        eof;        // The client has closed its side
+    };
+
+    std::string path;
+    int listenFd;
+    std::vector<Client*> clients;
+    std::unordered_map<std::string, RpnCachedProgram*> cache;
+    std::string key;            // Text of the current request
+    RealStack stack;
+    RpnOutput ignored;          // "=" and "show" are ignored
+
+public:
+    RpnServer():
+        path(),
+        listenFd(-1),
+        clients(),
+        cache(),
+        key(),
+        stack(),
+        ignored(-1, 64)
+    {}
+
+    ~RpnServer();
+
+    // Create the socket; an existing file of the path is removed.
+    // Return value: false on error (see errno)
+    bool open(const char* socketPath);
+
+    // Serve the clients until stop()
+    void run();
+
+    // Make run() return (can be called by a signal handler)
+    static void stop();
+
+    int cachedPrograms() const { return (int) cache.size(); }
+
+private:
+    RpnServer(const RpnServer&);                // Not implemented
+    RpnServer& operator=(const RpnServer&);     // Not implemented
+
+    void accept();
+    bool receive(Client& c);
+    bool send(Client& c);
+    void close(int i);
+    void compute(const char* text, size_t length, std::string& out);
+    RpnCachedProgram* compile(const char* text, size_t length);
+    void clearCache();
+};
+
+#endif
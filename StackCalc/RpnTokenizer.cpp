@@ -0,0 +1,422 @@
+//
+// Tokenizer of programs of the stack calculator
+//
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <charconv>
+#include "RpnProgram.h"
+#include "RpnTokenizer.h"
+
+//
+// Table of commands with a perfect hash.
+// The hash of a name is (c0*a + cl*b + cm + length) mod size,
+// where c0, cl, cm are its first, last and middle characters;
+// the parameters a, b are found at compile time, so that there
+// are no collisions.
+//
+
+class RpnCommand {
+public:
+    const char* name;
+    int         kind;       // RPN_TOKEN_COMMAND or RPN_TOKEN_KEYWORD
+    int         opcode;     // RpnOpcode or RpnKeyword
+};
+
+static constexpr RpnCommand commands[] = {
+    { "+",          RPN_TOKEN_COMMAND,  RPN_ADD },
+    { "-",          RPN_TOKEN_COMMAND,  RPN_SUB },
+    { "*",          RPN_TOKEN_COMMAND,  RPN_MUL },
+    { "/",          RPN_TOKEN_COMMAND,  RPN_DIV },
+    { "%",          RPN_TOKEN_COMMAND,  RPN_MOD },
+    { "<",          RPN_TOKEN_COMMAND,  RPN_LT },
+    { ">",          RPN_TOKEN_COMMAND,  RPN_GT },
+    { "<=",         RPN_TOKEN_COMMAND,  RPN_LE },
+    { ">=",         RPN_TOKEN_COMMAND,  RPN_GE },
+    { "==",         RPN_TOKEN_COMMAND,  RPN_EQ },
+    { "!=",         RPN_TOKEN_COMMAND,  RPN_NE },
+    { "pow",        RPN_TOKEN_COMMAND,  RPN_POW },
+    { "atan2",      RPN_TOKEN_COMMAND,  RPN_ATAN2 },
+    { "sin",        RPN_TOKEN_COMMAND,  RPN_SIN },
+    { "cos",        RPN_TOKEN_COMMAND,  RPN_COS },
+    { "exp",        RPN_TOKEN_COMMAND,  RPN_EXP },
+    { "log",        RPN_TOKEN_COMMAND,  RPN_LOG },
+    { "sqrt",       RPN_TOKEN_COMMAND,  RPN_SQRT },
+    { "=",          RPN_TOKEN_COMMAND,  RPN_DISPLAY },
+    { "pop",        RPN_TOKEN_COMMAND,  RPN_POP },
+    { "dup",        RPN_TOKEN_COMMAND,  RPN_DUP },
+    { "exch",       RPN_TOKEN_COMMAND,  RPN_EXCH },
+    { "clear",      RPN_TOKEN_COMMAND,  RPN_CLEAR },
+    { "show",       RPN_TOKEN_COMMAND,  RPN_SHOW },
+    { "stats",      RPN_TOKEN_COMMAND,  RPN_STATS },
+    { "i",          RPN_TOKEN_COMMAND,  RPN_INDEX },
+    { "quit",       RPN_TOKEN_COMMAND,  RPN_QUIT },
+    { ":",          RPN_TOKEN_KEYWORD,  RPN_KEYWORD_COLON },
+    { ";",          RPN_TOKEN_KEYWORD,  RPN_KEYWORD_SEMICOLON },
+    { "variable",   RPN_TOKEN_KEYWORD,  RPN_KEYWORD_VARIABLE },
+    { "to",         RPN_TOKEN_KEYWORD,  RPN_KEYWORD_TO },
+    { "if",         RPN_TOKEN_KEYWORD,  RPN_KEYWORD_IF },
+    { "else",       RPN_TOKEN_KEYWORD,  RPN_KEYWORD_ELSE },
+    { "then",       RPN_TOKEN_KEYWORD,  RPN_KEYWORD_THEN },
+    { "begin",      RPN_TOKEN_KEYWORD,  RPN_KEYWORD_BEGIN },
+    { "until",      RPN_TOKEN_KEYWORD,  RPN_KEYWORD_UNTIL },
+    { "while",      RPN_TOKEN_KEYWORD,  RPN_KEYWORD_WHILE },
+    { "repeat",     RPN_TOKEN_KEYWORD,  RPN_KEYWORD_REPEAT },
+    { "do",         RPN_TOKEN_KEYWORD,  RPN_KEYWORD_DO },
+    { "loop",       RPN_TOKEN_KEYWORD,  RPN_KEYWORD_LOOP }
+};
+
+static constexpr int NUM_COMMANDS = sizeof(commands) / sizeof(commands[0]);
+static constexpr unsigned HASH_SIZE = 128;      // Power of 2
+
+static constexpr int nameLength(const char* s) {
+    int n = 0;
+    while (s[n] != 0)
+        ++n;
+    return n;
+}
+
+static constexpr unsigned hash(
+    const char* s, int n, unsigned a, unsigned b
+) {
+    return (
+        (unsigned char) s[0] * a + (unsigned char) s[n-1] * b +
+        (unsigned char) s[n/2] + (unsigned) n
+    ) & (HASH_SIZE - 1);
+}
+
+class HashParameters {
+public:
+    unsigned a;
+    unsigned b;
+};
+
+static constexpr bool isPerfect(unsigned a, unsigned b) {
+    for (int i = 0; i < NUM_COMMANDS; ++i) {
+        const char* s = commands[i].name;
+        unsigned h = hash(s, nameLength(s), a, b);
+        for (int j = 0; j < i; ++j) {
+            const char* t = commands[j].name;
+            if (hash(t, nameLength(t), a, b) == h)
+                return false;
+        }
+    }
+    return true;
+}
+
+static constexpr HashParameters findHash() {
+    for (unsigned a = 1; a < 64; ++a) {
+        for (unsigned b = 0; b < 64; ++b) {
+            if (isPerfect(a, b))
+                return HashParameters{ a, b };
+        }
+    }
+    return HashParameters{ 0, 0 };
+}
+
+static constexpr HashParameters hashParameters = findHash();
+static_assert(hashParameters.a != 0, "No perfect hash for the commands");
+
+// Index in the table of commands by hash, or -1
+class HashTable {
+public:
+    signed char index[HASH_SIZE];
+};
+
+static constexpr HashTable makeHashTable() {
+    HashTable t{};
+    for (unsigned i = 0; i < HASH_SIZE; ++i)
+        t.index[i] = (-1);
+    for (int i = 0; i < NUM_COMMANDS; ++i) {
+        const char* s = commands[i].name;
+        t.index[hash(s, nameLength(s), hashParameters.a, hashParameters.b)] =
+            (signed char) i;
+    }
+    return t;
+}
+
+static constexpr HashTable hashTable = makeHashTable();
+
+// Entry of the table or 0
+static const RpnCommand* findCommand(const char* name, int length) {
+    if (length <= 0)
+        return 0;
+    int i = hashTable.index[
+        hash(name, length, hashParameters.a, hashParameters.b)
+    ];
+    if (
+        i < 0 ||
+        nameLength(commands[i].name) != length ||
+        memcmp(commands[i].name, name, length) != 0
+    )
+        return 0;
+    return &(commands[i]);
+}
+
+int rpnCommandOpcode(const char* name, int length) {
+    const RpnCommand* c = findCommand(name, length);
+    if (c == 0 || c->kind != RPN_TOKEN_COMMAND)
+        return (-1);
+    return c->opcode;
+}
+
+// End of table of commands
+//======================================================
+
+static const size_t INPUT_BUFFER_SIZE = 1 << 20;
+
+static bool isSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v');
+}
+
+static bool isDigit(char c) {
+    return ('0' <= c && c <= '9');
+}
+
+// Parse the number t[0..e-t-1]: the usual decimal numbers by
+// from_chars, other forms (".5", "-.5", "0x10", "inf", "nan",
+// overflow and underflow) by strtod. As atof was used before,
+// a token beginning with a digit (or a sign and a digit) is a number
+// anyway, the value of its longest prefix that is a number ("2x" is 2).
+// Return value: false, if the token is not a number
+static bool parseNumber(const char* t, const char* e, double& value) {
+    const char* d = (t[0] == '-' || t[0] == '+'? t+1 : t);
+    bool digit = (d < e && isDigit(*d));
+    if (digit) {
+        // from_chars does not accept '+'
+        std::from_chars_result r =
+            std::from_chars(t[0] == '+'? t+1 : t, e, value);
+        if (r.ec == std::errc() && r.ptr == e)
+            return true;
+    } else if (
+        d == e || !(*d == '.' || *d == 'i' || *d == 'I' || *d == 'n' ||
+            *d == 'N')
+    ) {
+        return false;           // Not a number, without strtod
+    }
+    std::string s(t, e);
+    char* end;
+    value = strtod(s.c_str(), &end);
+    return (digit || (end == s.c_str() + s.size()));
+}
+
+RpnTokenizer::RpnTokenizer(const char* text):
+    fd(-1),
+    ownFd(false),
+    buffer(),
+    mapped(0),
+    mappedSize(0),
+    pos(text),
+    end(text + strlen(text)),
+    eof(true),
+    lines(0)
+{}
+
+RpnTokenizer::RpnTokenizer(const char* text, size_t length):
+    fd(-1),
+    ownFd(false),
+    buffer(),
+    mapped(0),
+    mappedSize(0),
+    pos(text),
+    end(text + length),
+    eof(true),
+    lines(0)
+{}
+
+RpnTokenizer::RpnTokenizer(int inputFd):
+    fd(inputFd),
+    ownFd(false),
+    buffer(INPUT_BUFFER_SIZE),
+    mapped(0),
+    mappedSize(0),
+    pos(0),
+    end(0),
+    eof(false),
+    lines(0)
+{
+    pos = end = &(buffer[0]);
+}
+
+RpnTokenizer::RpnTokenizer():
+    fd(-1),
+    ownFd(false),
+    buffer(),
+    mapped(0),
+    mappedSize(0),
+    pos(""),
+    end(pos),
+    eof(true),
+    lines(0)
+{}
+
+bool RpnTokenizer::open(const char* path) {
+    close();
+    int f = ::open(path, O_RDONLY);
+    if (f < 0)
+        return false;
+    struct stat st;
+    if (fstat(f, &st) < 0) {
+        ::close(f);
+        return false;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        fd = f;
+        ownFd = true;
+        buffer.resize(INPUT_BUFFER_SIZE);
+        pos = end = &(buffer[0]);
+        eof = false;
+        return true;
+    }
+    if (st.st_size > 0) {
+        void* p = mmap(0, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+        if (p == MAP_FAILED) {
+            ::close(f);
+            return false;
+        }
+        madvise(p, (size_t) st.st_size, MADV_SEQUENTIAL);
+        mapped = (const char*) p;
+        mappedSize = (size_t) st.st_size;
+    }
+    ::close(f);
+    pos = (mapped != 0? mapped : "");
+    end = pos + mappedSize;
+    eof = true;
+    return true;
+}
+
+void RpnTokenizer::close() {
+    if (mapped != 0)
+        munmap((void*) mapped, mappedSize);
+    if (ownFd)
+        ::close(fd);
+    fd = (-1);
+    ownFd = false;
+    mapped = 0;
+    mappedSize = 0;
+    pos = end = "";
+    eof = true;
+    lines = 0;
+}
+
+// Keep the unread part of buffer and read more data.
+// Return value: false, if nothing was read.
+bool RpnTokenizer::fill() {
+    if (eof)
+        return false;
+    size_t len = end - pos;
+    if (len == buffer.size()) {
+        // A very long token
+        size_t offset = pos - &(buffer[0]);
+        buffer.resize(2 * buffer.size());
+        pos = &(buffer[0]) + offset;
+    }
+    memmove(&(buffer[0]), pos, len);
+    pos = &(buffer[0]);
+    end = pos + len;
+    ssize_t n;
+    do {
+        n = ::read(fd, &(buffer[0]) + len, buffer.size() - len);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        eof = true;
+        return false;
+    }
+    end += n;
+    return true;
+}
+
+void RpnTokenizer::next(RpnToken& token) {
+    // Skip the spaces
+    while (true) {
+        while (pos < end && isSpace(*pos))
+            ++pos;
+        if (pos < end)
+            break;
+        if (!fill()) {
+            token.kind = RPN_TOKEN_END;
+            token.text = "";
+            token.length = 0;
+            return;
+        }
+    }
+    if (*pos == '\n') {
+        token.kind = RPN_TOKEN_NEWLINE;
+        token.text = pos;
+        token.length = 1;
+        ++pos;
+        ++lines;
+        return;
+    }
+
+    // The token must end before the end of data
+    const char* e = pos;
+    while (true) {
+        while (e < end && !isSpace(*e) && *e != '\n')
+            ++e;
+        if (e < end || eof)
+            break;
+        size_t offset = e - pos;
+        fill();
+        e = pos + offset;
+    }
+    token.text = pos;
+    token.length = (int)(e - pos);
+    pos = e;
+    classify(token);
+}
+
+void RpnTokenizer::classify(RpnToken& token) {
+    const char* t = token.text;
+    const char* e = t + token.length;
+    const RpnCommand* c = findCommand(t, token.length);
+    if (c != 0) {
+        token.kind = c->kind;
+        token.opcode = c->opcode;
+    } else if (parseNumber(t, e, token.value)) {
+        token.kind = RPN_TOKEN_NUMBER;
+    } else if (token.length > 1 && t[0] == '$' && isDigit(t[1])) {
+        int k;
+        std::from_chars_result r = std::from_chars(t+1, e, k);
+        if (r.ec != std::errc() || r.ptr != e || k < 1) {
+            token.kind = RPN_TOKEN_UNKNOWN;
+            return;
+        }
+        token.kind = RPN_TOKEN_FIELD;
+        token.field = k - 1;
+    } else if (t[0] == 'q' || t[0] == 'Q') {
+        token.kind = RPN_TOKEN_COMMAND;     // Any word beginning with q
+        token.opcode = RPN_QUIT;
+    } else {
+        token.kind = RPN_TOKEN_UNKNOWN;
+    }
+}
+
+void RpnTokenizer::skipLine() {
+    while (true) {
+        while (pos < end) {
+            if (*pos++ == '\n') {
+                ++lines;
+                return;
+            }
+        }
+        if (!fill())
+            return;
+    }
+}
+
+void RpnTokenizer::restOfLine(const char*& text, size_t& length) {
+    size_t n = 0;
+    while (true) {
+        while (pos + n < end && pos[n] != '\n')
+            ++n;
+        if (pos + n < end || !fill())
+            break;
+    }
+    text = pos;
+    length = n;
+}
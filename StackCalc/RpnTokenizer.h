@@ -0,0 +1,124 @@
+//
+// Tokenizer of programs of the stack calculator
+//
+#ifndef RPN_TOKENIZER_H
+#define RPN_TOKENIZER_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+enum RpnTokenKind {
+    RPN_TOKEN_END,          // End of input
+    RPN_TOKEN_NEWLINE,
+    RPN_TOKEN_COMMAND,      // opcode
+    RPN_TOKEN_NUMBER,       // value
+    RPN_TOKEN_FIELD,        // $k: field == k-1
+    RPN_TOKEN_KEYWORD,      // opcode is RpnKeyword
+    RPN_TOKEN_UNKNOWN       // A name (see "RpnDictionary.h")
+};
+
+// Words of definitions and control structures; they are compiled
+// to jumps, calls and variable operations (see RpnProgram::compile)
+enum RpnKeyword {
+    RPN_KEYWORD_COLON,      // ": name" begins a definition
+    RPN_KEYWORD_SEMICOLON,  // ";" ends it
+    RPN_KEYWORD_VARIABLE,   // "variable name"
+    RPN_KEYWORD_TO,         // "to name" stores to the variable
+    RPN_KEYWORD_IF,
+    RPN_KEYWORD_ELSE,
+    RPN_KEYWORD_THEN,
+    RPN_KEYWORD_BEGIN,
+    RPN_KEYWORD_UNTIL,
+    RPN_KEYWORD_WHILE,
+    RPN_KEYWORD_REPEAT,
+    RPN_KEYWORD_DO,
+    RPN_KEYWORD_LOOP
+};
+
+class RpnToken {
+public:
+    int         kind;
+    int         opcode;
+    double      value;
+    int         field;
+    const char* text;       // Valid until the next token
+    int         length;
+
+    RpnToken():
+        kind(RPN_TOKEN_END),
+        opcode(0),
+        value(0.),
+        field(0),
+        text(""),
+        length(0)
+    {}
+
+    std::string str() const { return std::string(text, length); }
+};
+
+// Opcode of the command name[0..length-1] or -1 (also for keywords).
+// The commands and keywords are found by a perfect hash computed
+// at compile time.
+int rpnCommandOpcode(const char* name, int length);
+
+//
+// The tokens are taken directly from a buffer: a string in memory,
+// a file mapped to memory, or a large buffer read from a file
+// descriptor (a pipe or a terminal). The numbers are parsed
+// by std::from_chars or, in other forms that strtod accepts
+// (".5", "0x10", "inf", "nan"), by strtod.
+//
+class RpnTokenizer {
+    int                 fd;         // Input descriptor or -1
+    bool                ownFd;      // fd is opened by open()
+    std::vector<char>   buffer;     // Buffer of input from fd
+    const char*         mapped;     // File mapped to memory
+    size_t              mappedSize;
+    const char*         pos;        // Unread part of input
+    const char*         end;
+    bool                eof;        // No more data after end
+    long                lines;      // Ends of line passed
+
+public:
+    // Tokens of the string
+    RpnTokenizer(const char* text);
+    RpnTokenizer(const char* text, size_t length);
+
+    // Tokens read from the file descriptor (not closed by tokenizer)
+    RpnTokenizer(int inputFd);
+
+    // Tokens of a file; use open() after this
+    RpnTokenizer();
+
+    ~RpnTokenizer() { close(); }
+
+    // A regular file is mapped to memory; other files (pipes,
+    // devices) are read by blocks.
+    // Return value: false, if the file cannot be opened
+    bool open(const char* path);
+    void close();
+
+    // Read the next token
+    void next(RpnToken& token);
+
+    // Skip the rest of line, including the end of line
+    void skipLine();
+
+    // The rest of the current line without the end of line; the data
+    // of the line are read, and they stay in place until a token
+    // after the line is read
+    void restOfLine(const char*& text, size_t& length);
+
+    // Number of the ends of line passed by next() and skipLine()
+    long lineNumber() const { return lines; }
+
+private:
+    RpnTokenizer(const RpnTokenizer&);              // Not implemented
+    RpnTokenizer& operator=(const RpnTokenizer&);   // Not implemented
+
+    bool fill();
+    static void classify(RpnToken& token);
+};
+
+#endif
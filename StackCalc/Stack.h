@@ -0,0 +1,187 @@
+//
+// Stack of elements of type T
+//
+#ifndef STACK_H
+#define STACK_H
+
+#include <assert.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+class StackException {
+public:
+    const char *reason;
+    StackException():
+        reason("")
+    {}
+
+    StackException(const char *cause):
+        reason(cause)
+    {}
+};
+
+//
+// The first N elements are kept inside the object, so that a small
+// stack does not use the heap at all. A larger stack is moved to
+// the heap; its size grows twice every time, the elements are moved
+// (by memcpy, if T is trivially copyable).
+//
+template <class T, int N = 16>
+class Stack {
+private:
+    T* elems;                   // inlineElems or an array in the heap
+    int maxElems;
+    int numElems;
+    T inlineElems[N];
+
+public:
+    Stack():
+        elems(inlineElems),
+        maxElems(N),
+        numElems(0)
+    {}
+
+    // Stack with room for maxSize elements
+    Stack(int maxSize):
+        elems(inlineElems),
+        maxElems(N),
+        numElems(0)
+    {
+        reserve(maxSize);
+    }
+
+    Stack(const Stack& s):
+        elems(inlineElems),
+        maxElems(N),
+        numElems(0)
+    {
+        *this = s;
+    }
+
+    ~Stack() {
+        if (elems != inlineElems)
+            delete[] elems;
+    }
+
+    Stack& operator=(const Stack& s);
+
+    void push(const T& x) {
+        if (numElems >= maxElems) {
+            T y(x);     // x may be an element, freed by grow()
+            grow(2*maxElems);
+            elems[numElems] = std::move(y);
+        } else {
+            elems[numElems] = x;
+        }
+        ++numElems;
+    }
+
+    T pop() {
+        if (numElems == 0)
+            throw StackException("Stack empty");
+        --numElems;
+        return elems[numElems];
+    }
+
+    const T& top() const {
+        if (numElems == 0)
+            throw StackException("Stack empty");
+        return elems[numElems - 1];
+    }
+
+    T& top() {
+        if (numElems == 0)
+            throw StackException("Stack empty");
+        return elems[numElems - 1];
+    }
+
+    int size() const { return numElems; }
+    int depth() const { return size(); }
+    int capacity() const { return maxElems; }
+
+    void clear() { numElems = 0; }
+    void init() { clear(); }
+    bool empty() const {
+        return (numElems == 0);
+    }
+
+    // Unchecked access for the interpreter of compiled programs
+    // (see "RpnInterp.h"), which checks the depth statically.
+    // The array of elements from bottom to top; it may move,
+    // when the stack grows
+    T* data() { return elems; }
+    const T* data() const { return elems; }
+    // Make room for n elements
+    void reserve(int n) {
+        if (n > maxElems)
+            grow(n < 2*maxElems? 2*maxElems : n);
+    }
+    // Set the depth, 0 <= n <= reserved size
+    void resize(int n) {
+        assert(0 <= n && n <= maxElems);
+        numElems = n;
+    }
+
+    // Element at depth i.
+    // elementAt(0) == top of stack
+    const T& elementAt(int i) const {
+        if (i < 0 || i >= numElems)
+            throw StackException("Out of bounds");
+        return elems[numElems - 1 - i];
+    }
+
+    T& elementAt(int i) {
+        if (i < 0 || i >= numElems)
+            throw StackException("Out of bounds");
+        return elems[numElems - 1 - i];
+    }
+
+private:
+    void grow(int n);
+    static void move(T* dst, T* src, int n);
+};
+
+template <class T, int N>
+void Stack<T, N>::move(T* dst, T* src, int n) {
+    if (std::is_trivially_copyable<T>::value) {
+        if (n > 0)
+            memcpy((void*) dst, (const void*) src, n * sizeof(T));
+    } else {
+        for (int i = 0; i < n; ++i)
+            dst[i] = std::move(src[i]);
+    }
+}
+
+template <class T, int N>
+void Stack<T, N>::grow(int n) {
+    assert(n > maxElems);
+    T* p = new T[n];
+    move(p, elems, numElems);
+    if (elems != inlineElems)
+        delete[] elems;
+    elems = p;
+    maxElems = n;
+}
+
+template <class T, int N>
+Stack<T, N>& Stack<T, N>::operator=(const Stack<T, N>& s) {
+    if (this == &s)
+        return *this;
+    numElems = 0;
+    reserve(s.numElems);
+    if (std::is_trivially_copyable<T>::value) {
+        if (s.numElems > 0) {
+            memcpy(
+                (void*) elems, (const void*) s.elems, s.numElems * sizeof(T)
+            );
+        }
+    } else {
+        for (int i = 0; i < s.numElems; ++i)
+            elems[i] = s.elems[i];
+    }
+    numElems = s.numElems;
+    return *this;
+}
+
+#endif
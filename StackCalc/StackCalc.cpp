@@ -1,173 +1,433 @@
 //
 // Stack Calculator (non-graphic version)
 //
+// Usage:
+//      StackCalc [-i | -q]     calculator reading the standard input
+//      StackCalc [-i | -q] -e program
+//                              execute the program and exit
+//      StackCalc [-i | -q] -f file
+//                              execute the file as the input
+//      StackCalc -csv program [-H]
+//                              compute the program for every line
+//                              of CSV file read from the standard
+//                              input; $k is the field k of line.
+//                              -H: skip the header line
+//      StackCalc -b [-j threads]
+//                              compute every line of the standard
+//                              input as a separate program and print
+//                              its result (the top of stack) or error
+//      StackCalc -s socket     serve the programs sent to the Unix
+//                              domain socket (see "RpnServer.h")
+// Every line of input is compiled to bytecode (see "RpnProgram.h")
+// and then executed (see "RpnInterp.h"); if it cannot be compiled
+// or executed as a whole (an unknown command, too few elements
+// in the stack), its commands are executed one by one, and only
+// those that fail are reported. In CSV mode, the program
+// is computed by columns (see "RpnColumns.h") or, if it can be
+// translated to machine code, by the code (see "RpnJit.h").
+// In batch mode (-b),
+// the lines are computed concurrently by a pool of threads (by default,
+// one per processor; see "RpnBatch.h"), and the results are printed
+// in the order of lines.
+//
+// The words (": name ... ;"), variables and control structures
+// are compiled as well; a definition or a control structure may take
+// several lines. The definitions are kept until the end.
+//
+// In the interactive mode (-i), every arithmetic operation displays
+// its result with 8 digits, and the output is written after every
+// line. In the quiet batch mode (-q), only "=" and "show" print;
+// the numbers are printed exactly (the shortest form that reads back
+// to the same number), and the output is written by large blocks.
+// Compiled with RPN_PROFILE defined, the calculator prints the profile
+// of the interpreter (see "RpnProfile.h") to the standard error
+// at exit, as well as by the command "stats".
+// By default, the mode is interactive, if the standard input is
+// a terminal, and batch otherwise; -e and -f are batch by default.
+//
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <string.h>
 #include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <vector>
+#include <charconv>
 #include "RealStack.h"
+#include "RpnProgram.h"
+#include "RpnInterp.h"
+#include "RpnTokenizer.h"
+#include "RpnColumns.h"
+#include "RpnOutput.h"
+#include "RpnDictionary.h"
+#include "RpnBatch.h"
+#include "RpnServer.h"
+#include "RpnProfile.h"
+#include "RpnJit.h"
 
-static void onAdd();
-static void onSub();
-static void onMul();
-static void onDiv();
-static void onMod();
-static void onPush(const char* line);
-static void onPop();
-static void onDup();
-static void onExch();
-static void onClear();
-static void display();
 static void printHelp();
-static void onShow();
+static void printUsage();
+static bool execute(RpnProgram& program, RpnTokenizer& tokens);
+static int csvMode(const char* text, bool header);
+static int batchMode(int threads);
+static int serverMode(const char* socketPath);
+#ifdef RPN_PROFILE
+static void printProfile();
+#endif
 
 static RealStack stack;
+static RpnDictionary dictionary;        // Words and variables
+static RpnOutput& output = rpnStandardOutput;
+static bool interactive = false;
 
-int main() {
-    printHelp();
+int main(int argc, char* argv[]) {
+    const char* text = 0;
+    const char* file = 0;
+    const char* csv = 0;
+    const char* socketPath = 0;
+    bool header = false;
+    bool batch = false;
+    int threads = 0;            // Number of processors
+    int mode = (-1);            // Interactive 1, batch 0, automatic -1
 
-    char line[128];
+#ifdef RPN_PROFILE
+    atexit(printProfile);
+#endif
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-i") == 0)
+            mode = 1;
+        else if (strcmp(argv[i], "-q") == 0)
+            mode = 0;
+        else if (strcmp(argv[i], "-e") == 0 && i+1 < argc)
+            text = argv[++i];
+        else if (strcmp(argv[i], "-f") == 0 && i+1 < argc)
+            file = argv[++i];
+        else if (strcmp(argv[i], "-csv") == 0 && i+1 < argc)
+            csv = argv[++i];
+        else if (strcmp(argv[i], "-H") == 0)
+            header = true;
+        else if (strcmp(argv[i], "-b") == 0)
+            batch = true;
+        else if (strcmp(argv[i], "-j") == 0 && i+1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+            socketPath = argv[++i];
+        else
+            printUsage();
+    }
+    if (
+        (text != 0) + (file != 0) + (csv != 0) + batch +
+        (socketPath != 0) > 1
+    )
+        printUsage();
+    if (csv != 0)
+        return csvMode(csv, header);
+    if (batch)
+        return batchMode(threads);
+    if (socketPath != 0)
+        return serverMode(socketPath);
 
-    while (scanf("%120s", line) > 0) {
-        int linelen = strlen(line);
-        try {
-            if (strcmp(line, "+") == 0)
-                onAdd();
-            else if (strcmp(line, "-") == 0)
-                onSub();
-            else if (strcmp(line, "*") == 0)
-                onMul();
-            else if (strcmp(line, "/") == 0)
-                onDiv();
-            else if (strcmp(line, "%") == 0)
-                onMod();
-            else if (strcmp(line, "=") == 0)
-                display();
-            else if (
-                (linelen > 0 && isdigit(line[0])) ||
-                (linelen > 1 && (line[0] == '-' || line[0] == '+') &&
-                    isdigit(line[1]))
-            )
-                onPush(line);
-            else if (strcmp(line, "pop") == 0)
-                onPop();
-            else if (strcmp(line, "dup") == 0)
-                onDup();
-            else if (strcmp(line, "exch") == 0)
-                onExch();
-            else if (strcmp(line, "clear") == 0)
-                onClear();
-            else if (strcmp(line, "show") == 0)
-                onShow();
-            else if (
-                strcmp(line, "") == 0 ||
-                (linelen > 0 && (line[0] == 'q' || line[0] == 'Q'))
-            )
-                break;
-            else
-                printHelp();
-        } catch (StackException& e) {
-            printf("Stack Exception: %s\n", e.reason);
+    if (mode < 0)
+        mode = (text == 0 && file == 0 && isatty(0));
+    interactive = (mode > 0);
+    output.setPrecision(interactive? 8 : 0);
+
+    RpnProgram program(&dictionary);
+    if (text != 0) {
+        RpnTokenizer tokens(text);
+        while (execute(program, tokens))
+            ;
+    } else if (file != 0) {
+        RpnTokenizer tokens;
+        if (!tokens.open(file)) {
+            perror(file);
+            return 1;
+        }
+        while (execute(program, tokens))
+            ;
+    } else {
+        if (interactive) {
+            printHelp();
+            output.flush();
         }
+        RpnTokenizer tokens(0);     // Standard input
+        while (execute(program, tokens))
+            ;
     }
+    output.flush();
     return 0;
 }
 
-static void onAdd() {
-    double y = stack.pop();
-    double x = stack.pop();
-    stack.push(x + y);
-    display();
+#ifdef RPN_PROFILE
+static void printProfile() {
+    rpnStandardOutput.flush();
+    RpnOutput err(2);
+    rpnProfilePrint(err);
 }
+#endif
 
-static void onSub() {
-    double y = stack.pop();
-    double x = stack.pop();
-    stack.push(x - y);
-    display();
+static void printUsage() {
+    fprintf(
+        stderr,
+        "Usage: StackCalc [-i | -q] [-e program | -f file]\n"
+        "       StackCalc -csv program [-H]\n"
+        "       StackCalc -b [-j threads]\n"
+        "       StackCalc -s socket\n"
+    );
+    exit(1);
 }
 
-static void onMul() {
-    double y = stack.pop();
-    double x = stack.pop();
-    stack.push(x * y);
-    display();
+static void printSyntaxError(const RpnSyntaxException& e) {
+    output.put(e.reason);
+    if (!e.token.empty()) {
+        output.put(": ");
+        output.put(e.token.c_str());
+    }
+    output.put('\n');
+    if (interactive)
+        printHelp();
 }
 
-static void onDiv() {
-    double y = stack.pop();
-    double x = stack.pop();
-    stack.push(x / y);
-    display();
+// Execute the commands of the line one by one, as the calculator
+// without compiler did: a command that fails is reported, and
+// the next ones are executed.
+// Return value: false after "quit"
+static bool executeCommands(
+    RpnProgram& program, const char* text, size_t length
+) {
+    RpnTokenizer tokens(text, length);
+    bool more = true;
+    while (more) {
+        try {
+            program.clear();
+            more = program.compileCommand(tokens, interactive);
+            if (!rpnExecute(program, stack))
+                return false;
+        } catch (RpnSyntaxException& e) {
+            printSyntaxError(e);
+        } catch (StackException& e) {
+            output.put("Stack Exception: ");
+            output.put(e.reason);
+            output.put('\n');
+        }
+    }
+    return true;
 }
 
-static void onMod() {
-    double y = stack.pop();
-    double x = stack.pop();
-    stack.push(fmod(x, y));
-    display();
+// Compile the next line of input and execute it. If the line
+// has an unknown command or needs more elements than the stack has,
+// its commands are executed one by one instead (see executeCommands).
+// A definition or a control structure of several lines is not split:
+// it is reported as a whole.
+// Return value: false at the end of input or after "quit"
+static bool execute(RpnProgram& program, RpnTokenizer& tokens) {
+    const char* text;
+    size_t length;
+    tokens.restOfLine(text, length);
+    long line = tokens.lineNumber();
+    bool more = true;
+    try {
+        program.clear();
+        more = program.compile(tokens, interactive, true);
+        if (
+            tokens.lineNumber() > line + 1 ||
+            (program.canRun(stack.size()) && program.columns() == 0)
+        ) {
+            if (!rpnExecute(program, stack))
+                more = false;
+        } else if (!executeCommands(program, text, length)) {
+            more = false;
+        }
+    } catch (RpnSyntaxException& e) {
+        if (tokens.lineNumber() > line + 1)
+            printSyntaxError(e);
+        else if (!executeCommands(program, text, length))
+            more = false;
+    } catch (StackException& e) {
+        output.put("Stack Exception: ");
+        output.put(e.reason);
+        output.put('\n');
+    }
+    if (interactive)
+        output.flush();
+    return more;
 }
 
-static void onPush(const char* line) {
-    double x = atof(line);
-    stack.push(x);
-}
+// Number of CSV lines computed at once
+const int CSV_CHUNK_SIZE = 65536;
 
-static void onPop() {
-    stack.pop();
+// Split the CSV line to numbers; the missing fields and the fields
+// that are not numbers are NaN
+static void parseCsvLine(const char* line, std::vector<double>& fields) {
+    const char* p = line;
+    for (size_t k = 0; k < fields.size(); ++k) {
+        const char* e = p;
+        while (*e != 0 && *e != ',' && *e != '\n' && *e != '\r')
+            ++e;
+        const char* b = p;
+        while (b < e && *b == ' ')
+            ++b;
+        if (b < e && *b == '+')
+            ++b;                // from_chars does not accept '+'
+        double x;
+        std::from_chars_result r = std::from_chars(b, e, x);
+        fields[k] = (r.ec == std::errc() && r.ptr > b? x : NAN);
+        p = (*e == ','? e + 1 : e);     // At the end, the rest is missing
+    }
 }
 
-static void onDup() {
-    stack.push(
-        stack.top()
-    );
+static void printCsvResults(const double* result, int n) {
+    for (int i = 0; i < n; ++i) {
+        output.putNumber(result[i]);
+        output.put('\n');
+    }
 }
 
-static void onExch() {
-    double y = stack.pop();
-    double x = stack.pop();
-    stack.push(y);
-    stack.push(x);
-}
+static int csvMode(const char* text, bool header) {
+    RpnProgram program(&dictionary);
+    try {
+        program.compile(text);
+    } catch (RpnSyntaxException& e) {
+        if (e.token.empty())
+            fprintf(stderr, "%s\n", e.reason);
+        else
+            fprintf(stderr, "%s: %s\n", e.reason, e.token.c_str());
+        return 1;
+    }
 
-static void onClear() {
-    stack.clear();
+    int numColumns = program.columns();
+    std::vector< std::vector<double> > columns(numColumns);
+    std::vector<const double*> columnData(numColumns);
+    for (int k = 0; k < numColumns; ++k) {
+        columns[k].resize(CSV_CHUNK_SIZE);
+        columnData[k] = &(columns[k][0]);
+    }
+    std::vector<double> fields(numColumns);
+    std::vector<double> result(CSV_CHUNK_SIZE);
+    RpnColumnEvaluator evaluator;
+    RpnJitCode jit;
+    jit.compile(program);       // Otherwise, the evaluator is used
+
+    char* line = 0;
+    size_t lineSize = 0;
+    int n = 0;
+    try {
+        if (header)
+            getline(&line, &lineSize, stdin);
+        while (true) {
+            bool eof = (getline(&line, &lineSize, stdin) <= 0);
+            if (!eof) {
+                parseCsvLine(line, fields);
+                for (int k = 0; k < numColumns; ++k)
+                    columns[k][n] = fields[k];
+                ++n;
+            }
+            if (n == CSV_CHUNK_SIZE || (eof && n > 0)) {
+                const double* const* data =
+                    (numColumns > 0? &(columnData[0]) : 0);
+                if (jit.compiled())
+                    jit.evaluate(data, n, &(result[0]));
+                else
+                    evaluator.evaluate(program, data, n, &(result[0]));
+                printCsvResults(&(result[0]), n);
+                n = 0;
+            }
+            if (eof)
+                break;
+        }
+    } catch (StackException& e) {
+        output.flush();
+        fprintf(stderr, "Stack Exception: %s\n", e.reason);
+        free(line);
+        return 1;
+    }
+    free(line);
+    output.flush();
+    return 0;
 }
 
-static void display() {
-    if (!stack.empty()) {
-        printf("= %.8g\n", stack.top());
-    } else {
-        printf("stack empty\n");
+// Number of lines computed at once in batch mode
+const int BATCH_SIZE = 65536;
+
+static int batchMode(int threads) {
+    RpnBatchEvaluator evaluator(threads);
+    std::vector<std::string> lines(BATCH_SIZE);
+    std::vector<const char*> texts(BATCH_SIZE);
+    std::vector<size_t> lengths(BATCH_SIZE);
+    std::vector<RpnBatchResult> results(BATCH_SIZE);
+
+    char* line = 0;
+    size_t lineSize = 0;
+    int n = 0;
+    while (true) {
+        ssize_t len = getline(&line, &lineSize, stdin);
+        bool eof = (len <= 0);
+        if (!eof) {
+            lines[n].assign(line, (size_t) len);
+            ++n;
+        }
+        if (n == BATCH_SIZE || (eof && n > 0)) {
+            for (int i = 0; i < n; ++i) {
+                texts[i] = lines[i].data();
+                lengths[i] = lines[i].size();
+            }
+            evaluator.evaluate(&(texts[0]), &(lengths[0]), n, &(results[0]));
+            for (int i = 0; i < n; ++i) {
+                if (results[i].error.empty())
+                    output.putNumber(results[i].value);
+                else
+                    output.put(results[i].error.c_str());
+                output.put('\n');
+            }
+            n = 0;
+        }
+        if (eof)
+            break;
     }
+    free(line);
+    output.flush();
+    return 0;
 }
 
-static void onShow() {
-    int d = stack.depth();
-    printf("Depth of stack = %d.", d);
-    if (d > 0)
-        printf(" Stack elements:\n");
-    else
-        printf("\n");
+static void stopServer(int) {
+    RpnServer::stop();
+}
 
-    for (int i = 0; i < d; i++) {
-        printf("\t%.8g\n", stack.elementAt(i));
+static int serverMode(const char* socketPath) {
+    RpnServer server;
+    if (!server.open(socketPath)) {
+        perror(socketPath);
+        return 1;
     }
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    server.run();
+    return 0;
 }
 
 static void printHelp() {
-    printf(
+    output.put(
         "Stack Calculator commands:\n"
         "\t<number>\tPush to stack\n"
-        "\t+, -, *, /, %%\tAriphmetic operations\n"
+        "\t$k\t\tPush the field k of record\n"
+        "\t+, -, *, /, %\tAriphmetic operations\n"
         "\t=\t\tDisplay the stack top\n"
         "\tpop\t\tRemove the stack top\n"
         "\tdup\t\tDuplicate the stack top\n"
         "\texch\t\tExchange two elements at the stack top\n"
         "\tshow\t\tShow the stack\n"
+        "\tstats\t\tShow the profile of interpreter\n"
         "\tclear\t\tErase the stack\n"
         "\tquit\t\tEnd the program\n"
+        "\t<, >, <=, >=, ==, !=\tComparisons (1 or 0)\n"
+        "\tsin, cos, exp, log, sqrt\tFunctions\n"
+        "\tx y pow, y x atan2\tx^y, atan(y/x)\n"
+        "\t: name ... ;\tDefine the word name\n"
+        "\tvariable name\tDefine the variable; name pushes it\n"
+        "\tto name\t\tPop to the variable\n"
+        "\tif ... [else ...] then\n"
+        "\tbegin ... until, begin ... while ... repeat\n"
+        "\tlimit start do ... i ... loop\n"
     );
 }
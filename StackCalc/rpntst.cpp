@@ -0,0 +1,259 @@
+//
+// Test of the stack calculator library
+//
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+#include <string>
+#include "RealStack.h"
+#include "RpnProgram.h"
+#include "RpnInterp.h"
+#include "RpnTokenizer.h"
+#include "RpnOutput.h"
+#include "RpnDictionary.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name) {
+    printf("%-50s %s\n", name, ok? "ok" : "FAILED");
+    if (!ok)
+        ++failures;
+}
+
+// Output written to a temporary file and read back
+class Capture {
+    FILE* file;
+public:
+    RpnOutput out;
+
+    Capture():
+        file(tmpfile()),
+        out(fileno(file), 4096)
+    {}
+
+    ~Capture() { fclose(file); }
+
+    std::string text() {
+        out.flush();
+        std::string s;
+        char buffer[4096];
+        ssize_t n;
+        lseek(fileno(file), 0, SEEK_SET);
+        while ((n = read(fileno(file), buffer, sizeof(buffer))) > 0)
+            s.append(buffer, (size_t) n);
+        return s;
+    }
+};
+
+// Push the top of stack, while the stack grows: from the inline
+// elements to the heap and then from an array in the heap to another
+static void testStackGrowth() {
+    RealStack s;
+    s.push(0.);
+    int growths = 0;
+    int capacity = s.capacity();
+    while (growths < 2) {
+        s.push(s.top());        // The element itself, then 1 more
+        s.top() += 1.;
+        if (s.capacity() != capacity) {
+            ++growths;
+            capacity = s.capacity();
+        }
+    }
+    bool ok = true;
+    for (int i = 0; i < s.size(); ++i) {
+        if (s.elementAt(i) != (double)(s.size() - 1 - i))
+            ok = false;
+    }
+    check(ok, "stack: push(top()) across growths");
+}
+
+static bool isNumber(const char* text, double& value) {
+    RpnTokenizer tokens(text);
+    RpnToken token;
+    tokens.next(token);
+    value = token.value;
+    return (token.kind == RPN_TOKEN_NUMBER);
+}
+
+// Value of the token or NaN, if it is not a number
+static double number(const char* text) {
+    double x;
+    return (isNumber(text, x)? x : NAN);
+}
+
+static void testNumbers() {
+    double x;
+    check(
+        number("1.5e3") == 1500. && number("+3") == 3. &&
+            number("-2") == (-2.) && number("1e999") == INFINITY,
+        "tokenizer: decimal numbers"
+    );
+    check(
+        number(".5") == 0.5 && number("-.5") == (-0.5) &&
+            number("0x10") == 16. && number("-inf") == (-INFINITY) &&
+            number("2x") == 2.,
+        "tokenizer: numbers as atof reads them"
+    );
+    check(
+        isNumber("nan", x) && isnan(x),
+        "tokenizer: nan"
+    );
+    check(
+        !isNumber("in", x) && !isNumber("nancy", x) &&
+            !isNumber("-", x) && !isNumber("i", x),
+        "tokenizer: not numbers"
+    );
+}
+
+// Output of the compiled (and optimized) program executed with
+// the stack given, which is left with the result
+static std::string run(RpnProgram& program, RealStack& stack) {
+    Capture c;
+    c.out.setPrecision(8);
+    try {
+        rpnExecute(program, stack, 0, 0, &(c.out));
+    } catch (StackException&) {
+        c.out.put("!\n");
+    }
+    return c.text();
+}
+
+static std::string run(const char* text) {
+    RpnDictionary dictionary;
+    RpnProgram program(&dictionary);
+    RealStack stack;
+    program.compile(text);
+    return run(program, stack);
+}
+
+static int count(const RpnProgram& program, int opcode) {
+    int n = 0;
+    for (int i = 0; i < program.size(); ++i) {
+        if (rpnOpcode(program.instructions()[i]) == opcode)
+            ++n;
+    }
+    return n;
+}
+
+static void testOptimizer() {
+    RpnProgram p;
+    p.compile("1 2 + 3 * 4 -");
+    check(
+        p.size() == 2 && p.numConstants() == 1 &&
+            p.constantPool()[0] == 5.,
+        "optimizer: constants folded"
+    );
+
+    // "=" and "show" print the values before the operation
+    check(run("1 2 = + =") == "= 2\n= 3\n", "optimizer: no fold across =");
+    check(
+        run("4 2 show / 1 - =") ==
+            "Depth of stack = 2. Stack elements:\n\t2\n\t4\n= 1\n",
+        "optimizer: no fold across show"
+    );
+
+    // The + after "then" is a jump target: "3 +" is not folded
+    check(
+        run("10 1 if 2 else 3 then + = 10 0 if 2 else 3 then + =") ==
+            "= 12\n= 13\n",
+        "optimizer: jump target after a constant"
+    );
+    check(
+        run("0 begin 1 + dup 5 >= until = 1 5 0 do 2 * loop =") ==
+            "= 5\n= 32\n",
+        "optimizer: loops"
+    );
+
+    // The removed pairs need the same depth of stack as before
+    p.clear();
+    p.compile("dup pop");
+    check(
+        count(p, RPN_DUP) == 0 && !p.canRun(0) && p.canRun(1),
+        "optimizer: dup pop at depth 0"
+    );
+    p.clear();
+    p.compile("exch exch 7 pop");
+    check(
+        p.size() == 1 && !p.canRun(1) && p.canRun(2),
+        "optimizer: exch exch at depth 0"
+    );
+    RealStack stack;
+    check(run(p, stack) == "!\n" && stack.empty(), "optimizer: underflow");
+
+    // The constants of a word are copied to the place of call,
+    // in the order of instructions
+    check(
+        run(": w 2 + 3 * ; 1 w w = : a 10 ; : b a a + ; b b * =") ==
+            "= 33\n= 400\n",
+        "optimizer: inlined words with constants"
+    );
+    RpnDictionary dictionary;
+    RpnProgram q(&dictionary);
+    q.compile(": w 2 + 3 * ; 1 w w");
+    const double inlined[] = { 1., 2., 3., 2., 3. };
+    bool ok = (q.numConstants() == 5 && count(q, RPN_PUSH_MUL) == 2);
+    for (int i = 0; ok && i < 5; ++i)
+        ok = (q.constantPool()[i] == inlined[i]);
+    check(ok, "optimizer: constants of inlined words");
+    q.clear();
+    q.compile("5 w");
+    RealStack result;
+    check(
+        run(q, result) == "" && result.size() == 1 && result.top() == 21.,
+        "optimizer: word compiled before"
+    );
+}
+
+// Execute the line command by command, as StackCalc does when
+// the line fails as a whole; the errors are written as "!".
+static std::string runCommands(const char* line) {
+    Capture c;
+    c.out.setPrecision(8);
+    RpnDictionary dictionary;
+    RpnProgram program(&dictionary);
+    RealStack stack;
+    RpnTokenizer tokens(line);
+    bool more = true;
+    while (more) {
+        try {
+            program.clear();
+            more = program.compileCommand(tokens);
+            if (!rpnExecute(program, stack, 0, 0, &(c.out)))
+                break;
+        } catch (RpnSyntaxException&) {
+            c.out.put("!\n");
+        } catch (StackException&) {
+            c.out.put("!\n");
+        }
+    }
+    return c.text();
+}
+
+static void testCommands() {
+    check(
+        runCommands("3 dup * = pop pop 7 =") == "= 9\n!\n= 7\n",
+        "commands: underflow in the middle of line"
+    );
+    check(
+        runCommands("2 3 foo + =") == "!\n= 5\n",
+        "commands: unknown command"
+    );
+    check(
+        runCommands("variable x 4 to x x x * = quit 1 =") == "= 16\n",
+        "commands: variable and quit"
+    );
+    check(
+        runCommands("1 if 2 = else 3 = then : w 5 ; w =") == "= 2\n= 5\n",
+        "commands: control structure and definition"
+    );
+}
+
+int main() {
+    testStackGrowth();
+    testNumbers();
+    testOptimizer();
+    testCommands();
+    printf("%d failed\n", failures);
+    return (failures != 0);
+}